@@ -0,0 +1,56 @@
+/* Exposed functions of algebra.c */
+#ifndef ALGEBRA_H
+#define ALGEBRA_H
+
+#include <stddef.h>
+
+#include "types.h"
+
+/**
+ * @brief Add two compressed arrays without decompressing them to floats.
+ * @param output Output stream and compression parameters of the sum.
+ * @param a/b Compressed operands (positioned at their first block).
+ * @param input Shape of the arrays (the data pointer is not used).
+ * @return Size of the compressed sum in bytes, as zfp_compress(), or 0 if
+ *  any stream is adaptive (see set_zfp_output_adaptive()).
+ * @note Each pair of blocks is decoded to exponent and decorrelated
+ *  coefficients, aligned to the larger exponent, added and re-coded. The
+ *  decorrelating transform is linear up to rounding, so the sum matches
+ *  compressing the decompressed sum to within the operands' tolerances.
+*/
+size_t zfp_add(zfp_output *output, zfp_output *a, zfp_output *b,
+               const zfp_input *input);
+
+/* Reductions over the values of a compressed array */
+typedef struct {
+  size_t count;  /* number of values reduced */
+  double sum;    /* sum of the values */
+  double sumsq;  /* sum of the squared values (squared L2 norm) */
+  double error;  /* bound on the L2 norm of the dropped bit planes */
+} zfp_reduction;
+
+/**
+ * @brief Reduce a compressed array without writing the decoded values.
+ * @param output Compressed stream and compression parameters.
+ * @param input Shape of the array (the data pointer is not used).
+ * @param readprec Number of leading bit planes to read per block
+ *  (ZFP_MAX_PREC for the exact reduction of the decoded array).
+ * @param r Reductions (count, sum, sum of squares, error bound).
+ * @return void
+ * @note Each block stops after the bit plane decode and inverse transform.
+ *  With a small readprec the sums are a fast approximation, and
+ *  sqrt(sumsq) + error bounds the L2 norm of the decoded array. An adaptive
+ *  stream is not read and leaves r->count at 0.
+*/
+void zfp_reduce(zfp_output *output, const zfp_input *input, uint readprec,
+                zfp_reduction *r);
+
+/**
+ * @brief Dot product of two compressed arrays of the same shape.
+ * @param readprec Number of leading bit planes to read per block.
+ * @return Dot product of the decoded arrays, 0 if either is adaptive.
+*/
+double zfp_dot(zfp_output *a, zfp_output *b, const zfp_input *input,
+               uint readprec);
+
+#endif // ALGEBRA_H
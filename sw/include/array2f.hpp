@@ -0,0 +1,236 @@
+#ifndef ARRAY2F_HPP
+#define ARRAY2F_HPP
+
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <list>
+#include <unordered_map>
+#include <vector>
+
+#include "types.h"
+#include "stream.h"
+#include "encode.h"
+#include "decode.h"
+
+/**
+ * @brief 2D float array stored as fixed-rate compressed 4x4 blocks.
+ * @note Every block takes the same whole number of stream words, so any
+ *  block is decoded or re-encoded in place. Accessed blocks are kept decoded
+ *  in an LRU cache and encoded back when they are evicted (if modified).
+ *  The compressed data is laid out as zfp_compress() lays out a fixed-rate
+ *  stream of the same array.
+*/
+class compressed_array2f {
+public:
+  /* Proxy for a writable element */
+  class reference {
+  public:
+    operator float() const { return array->get(x, y); }
+    reference& operator=(float v) { array->set(x, y, v); return *this; }
+    reference& operator=(const reference& r) { return *this = float(r); }
+    reference& operator+=(float v) { return *this = float(*this) + v; }
+    reference& operator-=(float v) { return *this = float(*this) - v; }
+    reference& operator*=(float v) { return *this = float(*this) * v; }
+    reference& operator/=(float v) { return *this = float(*this) / v; }
+
+  private:
+    friend class compressed_array2f;
+    reference(compressed_array2f *array, size_t x, size_t y) :
+      array(array), x(x), y(y) {}
+    compressed_array2f *array;
+    size_t x, y;
+  };
+
+  /**
+   * @brief Construct an nx*ny array of zeros.
+   * @param rate Number of compressed bits per value (rounded up to a
+   *  multiple of 4, i.e., one 64-bit word per block).
+   * @param cache_blocks Number of decoded blocks kept in the cache.
+  */
+  compressed_array2f(size_t nx, size_t ny, double rate,
+                     size_t cache_blocks = 64) :
+    nx(nx), ny(ny), bx((nx + 3) / 4), by((ny + 3) / 4),
+    capacity(cache_blocks ? cache_blocks : 1), last(NONE), last_line(0)
+  {
+    output = alloc_zfp_output();
+    set_zfp_output_rate(output, rate, 2);
+    //* Word-aligned blocks can be rewritten without touching their neighbors.
+    uint bits = (uint)((output->maxbits + SWORD_BITS - 1) / SWORD_BITS *
+                       SWORD_BITS);
+    output->minbits = output->maxbits = bits;
+    size_t bytes = bx * by * (bits / CHAR_BIT);
+    //* An all-zero stream decodes as blocks of zeros.
+    output->data = stream_init(calloc(bytes, 1), bytes);
+  }
+
+  ~compressed_array2f() { free_zfp_output(output); }
+
+  size_t size_x() const { return nx; }
+  size_t size_y() const { return ny; }
+  /* Number of compressed bits per value */
+  double rate() const { return (double)output->maxbits / BLOCK_SIZE_2D; }
+  /* Size of the compressed data in bytes (the cache is not included) */
+  size_t compressed_bytes() const
+  {
+    return bx * by * (output->maxbits / CHAR_BIT);
+  }
+  /* Compressed data, after writing back the modified cached blocks */
+  const void *compressed_data() const
+  {
+    flush();
+    return output->data->begin;
+  }
+
+  float operator()(size_t x, size_t y) const { return get(x, y); }
+  reference operator()(size_t x, size_t y) { return reference(this, x, y); }
+
+  float get(size_t x, size_t y) const
+  {
+    return fetch(block_index(x, y))[(x & 3) + 4 * (y & 3)];
+  }
+
+  void set(size_t x, size_t y, float v)
+  {
+    size_t b = block_index(x, y);
+    fetch(b)[(x & 3) + 4 * (y & 3)] = v;
+    lines[last_line].dirty = true;
+  }
+
+  /* Compress a dense row-major array (the cache is discarded) */
+  void set(const float *data)
+  {
+    clear_cache();
+    for (size_t j = 0; j < by; j++)
+      for (size_t i = 0; i < bx; i++) {
+        float fblock[BLOCK_SIZE_2D];
+        const float *raw = data + 4 * i + nx * 4 * j;
+        if (nx - 4 * i < 4 || ny - 4 * j < 4)
+          gather_partial_2d_block(fblock, raw, MIN(nx - 4 * i, (size_t)4),
+                                  MIN(ny - 4 * j, (size_t)4), 1, nx);
+        else
+          gather_2d_block(fblock, raw, 1, nx);
+        encode_block(i + bx * j, fblock);
+      }
+  }
+
+  /* Decompress to a dense row-major array */
+  void get(float *data) const
+  {
+    for (size_t j = 0; j < by; j++)
+      for (size_t i = 0; i < bx; i++) {
+        float fblock[BLOCK_SIZE_2D];
+        size_t b = i + bx * j;
+        std::unordered_map<size_t, size_t>::const_iterator it = index.find(b);
+        if (it != index.end())
+          memcpy(fblock, lines[it->second].values, sizeof(fblock));
+        else
+          decode_block(b, fblock);
+        float *raw = data + 4 * i + nx * 4 * j;
+        scatter_partial_2d_block(fblock, raw, MIN(nx - 4 * i, (size_t)4),
+                                 MIN(ny - 4 * j, (size_t)4), 1, nx);
+      }
+  }
+
+  /* Write back all modified blocks (they stay cached) */
+  void flush() const
+  {
+    for (size_t l = 0; l < lines.size(); l++)
+      if (lines[l].dirty) {
+        encode_block(lines[l].block, lines[l].values);
+        lines[l].dirty = false;
+      }
+  }
+
+private:
+  compressed_array2f(const compressed_array2f&);
+  compressed_array2f& operator=(const compressed_array2f&);
+
+  static const size_t NONE = (size_t)-1;
+
+  /* A decoded block */
+  struct line {
+    size_t block;
+    bool dirty;
+    float values[BLOCK_SIZE_2D];
+  };
+
+  size_t block_index(size_t x, size_t y) const { return x / 4 + bx * (y / 4); }
+
+  void encode_block(size_t b, const float *values) const
+  {
+    float fblock[BLOCK_SIZE_2D];
+    size_t mx = MIN(nx - 4 * (b % bx), (size_t)4);
+    size_t my = MIN(ny - 4 * (b / bx), (size_t)4);
+    //* Pad partial blocks as the array compressor does.
+    if (mx < 4 || my < 4) {
+      gather_partial_2d_block(fblock, values, mx, my, 1, 4);
+      values = fblock;
+    }
+    stream_wseek(output->data, (uint64)b * output->maxbits);
+    encode_fblock(output, values, 2);
+    stream_flush(output->data);
+  }
+
+  void decode_block(size_t b, float *values) const
+  {
+    stream_rseek(output->data, (uint64)b * output->maxbits);
+    decode_fblock(output, values, 2);
+  }
+
+  /* Return the decoded values of block b, loading it into the cache */
+  float *fetch(size_t b) const
+  {
+    //* Consecutive accesses mostly hit the most recently used block.
+    if (b == last)
+      return lines[last_line].values;
+    std::unordered_map<size_t, size_t>::iterator it = index.find(b);
+    size_t l;
+    if (it != index.end()) {
+      l = it->second;
+      lru.splice(lru.begin(), lru, order[l]);
+    } else {
+      if (lines.size() < capacity) {
+        l = lines.size();
+        lines.push_back(line());
+        order.push_back(lru.insert(lru.begin(), l));
+      } else {
+        //* Evict the least recently used block, encoding it if modified.
+        l = lru.back();
+        lru.splice(lru.begin(), lru, order[l]);
+        if (lines[l].dirty)
+          encode_block(lines[l].block, lines[l].values);
+        index.erase(lines[l].block);
+      }
+      lines[l].block = b;
+      lines[l].dirty = false;
+      decode_block(b, lines[l].values);
+      index[b] = l;
+    }
+    last = b;
+    last_line = l;
+    return lines[l].values;
+  }
+
+  void clear_cache()
+  {
+    lines.clear();
+    order.clear();
+    lru.clear();
+    index.clear();
+    last = NONE;
+  }
+
+  size_t nx, ny;       /* size of the array */
+  size_t bx, by;       /* number of blocks in x and y */
+  size_t capacity;     /* maximum number of cached blocks */
+  zfp_output *output;  /* fixed-rate compressed blocks */
+  mutable std::vector<line> lines;                         /* cached blocks */
+  mutable std::vector<std::list<size_t>::iterator> order;  /* lines in lru */
+  mutable std::list<size_t> lru;                  /* lines, most recent first */
+  mutable std::unordered_map<size_t, size_t> index;        /* block -> line */
+  mutable size_t last, last_line;  /* most recently used block and its line */
+};
+
+#endif // ARRAY2F_HPP
@@ -0,0 +1,31 @@
+/* Exposed functions of bfp.c */
+#ifndef BFP_H
+#define BFP_H
+
+#include <stddef.h>
+
+#include "types.h"
+
+/**
+ * @brief Number of bits per value of the block-floating-point layout.
+ * @return output->maxprec clamped to [1, 31].
+*/
+uint get_bfp_precision(const zfp_output *output);
+
+/**
+ * @brief Compress a 1D/2D array as block-floating-point integers only.
+ * @param output Output stream; its precision (set_zfp_output_precision())
+ *  sets the bits per value P.
+ * @param input Array to compress.
+ * @return Size of the compressed stream in bytes, as zfp_compress().
+ * @note Blocks go through the gather, emax and fwd_cast_block() stages and
+ *  nothing else: each block is its biased exponent (EBITS) followed by the
+ *  top P bits of each integer (two's complement, block_size * P bits). No
+ *  lifting and no embedded coding, so every block has the same size and
+ *  decoding is a sign-extending shift per value. Errors are below
+ *  2^(emax - P) per value; ratio is 32 / (P + EBITS / block_size).
+*/
+size_t zfp_compress_bfp(zfp_output *output, const zfp_input *input);
+size_t zfp_decompress_bfp(zfp_output *output, const zfp_input *input);
+
+#endif // BFP_H
@@ -0,0 +1,85 @@
+/* Exposed functions of bucket.c */
+#ifndef BUCKET_H
+#define BUCKET_H
+
+#include <stddef.h>
+
+#include "types.h"
+
+/**
+ * @brief A flattened gradient tensor.
+ * @note A tensor of shape [d0][d1]...[dk] is described as rows = d0*...*d(k-1)
+ *  and cols = dk, e.g., a conv weight [out][in][kh][kw] has rows = out*in*kh and
+ *  cols = kw, or rows = out and cols = in*kh*kw if the caller prefers that view.
+*/
+typedef struct {
+  float *data;  /* pointer to the row-major tensor values */
+  size_t rows;  /* number of rows (all but the innermost dimension) */
+  size_t cols;  /* number of values per row (innermost dimension) */
+} zfp_tensor;
+
+/* Placement of one tensor inside a bucket */
+typedef struct {
+  size_t tensor; /* index of the tensor in the caller's tensor list */
+  size_t y;      /* first bucket row occupied by the tensor */
+  size_t wrap;   /* number of bucket rows spanned by one tensor row */
+} zfp_bucket_slot;
+
+/* A 2D bucket of nx*ny floats holding consecutive tensors */
+typedef struct {
+  size_t nx, ny;          /* shape of the bucket (both multiples of 4) */
+  size_t used;            /* number of bucket rows holding tensor values */
+  size_t count;           /* number of tensors in the bucket */
+  zfp_bucket_slot *slots; /* placement of each tensor */
+} zfp_bucket;
+
+/* All buckets needed to carry a list of tensors */
+typedef struct {
+  size_t num_buckets;  /* number of buckets */
+  zfp_bucket *buckets; /* buckets in tensor order */
+} zfp_bucket_layout;
+
+/**
+ * @brief Plan how to pack tensors into fixed-size 2D buckets.
+ * @param tensors List of tensors (only the shapes are used).
+ * @param count Number of tensors.
+ * @param capacity Maximum number of tensor values per bucket (a larger
+ *  tensor gets a bucket of its own).
+ * @return Layout of the buckets, freed with free_zfp_bucket_layout().
+ * @note The plan only depends on the tensor shapes and capacity, so the
+ *  receiver recomputes the same layout without it being sent on the wire.
+ *  Every row of a tensor starts on a new bucket row, and the bucket width is
+ *  chosen per bucket to minimize padding, so no 4x4 block is ever partial.
+*/
+zfp_bucket_layout *plan_zfp_buckets(const zfp_tensor *tensors, size_t count,
+                                    size_t capacity);
+void free_zfp_bucket_layout(zfp_bucket_layout *layout);
+
+/**
+ * @brief Copy the tensors of a bucket into a contiguous nx*ny array.
+ * @param dst Pointer to the bucket array (nx*ny floats).
+ * @param bucket Bucket to pack.
+ * @param tensors The tensor list given to plan_zfp_buckets().
+ * @return void
+ * @note Padding replicates the last value of each row segment and the last
+ *  used row, as pad_partial_block() does within a block.
+*/
+void pack_zfp_bucket(float *dst, const zfp_bucket *bucket,
+                     const zfp_tensor *tensors);
+
+/**
+ * @brief Restore the tensors of a bucket from a (decompressed) bucket array.
+ * @param src Pointer to the bucket array (nx*ny floats).
+ * @param bucket Bucket to unpack.
+ * @param tensors The tensor list given to plan_zfp_buckets().
+ * @return void
+*/
+void unpack_zfp_bucket(const float *src, const zfp_bucket *bucket,
+                       const zfp_tensor *tensors);
+
+/**
+ * @brief Describe a packed bucket array as a 2D compression input.
+*/
+zfp_input *init_zfp_bucket_input(float *data, const zfp_bucket *bucket);
+
+#endif // BUCKET_H
@@ -0,0 +1,69 @@
+/* Exposed functions of cap.c */
+#ifndef CAP_H
+#define CAP_H
+
+#include <stddef.h>
+
+#include "types.h"
+
+/* What a capped encoder does with the blocks that do not fit */
+typedef enum {
+  zfp_overflow_resume     = 0, /* stop; code them later into another buffer */
+  zfp_overflow_fixed_rate = 1  /* code them at the fixed rate that fits */
+} zfp_overflow;
+
+/**
+ * @brief Progress of an array coded into byte-capped buffers (mirrored by
+ *  the decoder).
+*/
+typedef struct {
+  zfp_overflow overflow; /* overflow policy of the encoder */
+  size_t block;          /* next block to code (all blocks: done) */
+  uint fallback_bits;    /* bits per block of the fixed-rate tail (0: none) */
+} zfp_cap;
+
+/**
+ * @brief Allocate the state of a capped encoder or decoder.
+ * @return State starting at block 0, freed with free_zfp_cap().
+*/
+zfp_cap *alloc_zfp_cap(zfp_overflow overflow);
+void free_zfp_cap(zfp_cap *cap);
+
+/**
+ * @brief Start over at the first block (e.g., for the next array).
+*/
+void reset_zfp_cap(zfp_cap *cap);
+
+/**
+ * @brief Compress the next blocks of a 1D/2D array without writing past the
+ *  end of the output buffer.
+ * @param output Output stream; its capacity is the byte cap.
+ * @param input Array to compress.
+ * @param cap Progress, advanced past the blocks coded.
+ * @return Size of the compressed stream in bytes, as zfp_compress().
+ * @note Blocks are coded with the output settings while they fit. Once a
+ *  block ends past the cap, it is rolled back; with zfp_overflow_fixed_rate,
+ *  coding rewinds further, to the latest block that leaves half the mean
+ *  budget per block for each block after it, and the remaining blocks are
+ *  coded at the largest fixed rate that fills the buffer. An array that
+ *  fits is coded as with the output settings alone. With
+ *  zfp_overflow_resume, coding stops at the block that crossed the cap and
+ *  cap->block tells where the next call (with another buffer) resumes. If
+ *  no block fits, cap->block does not move; a buffer smaller than the
+ *  header word is left untouched and 0 is returned.
+ *
+ *  Layout: the number of blocks coded with the output settings (48 bits)
+ *  and fallback_bits (16 bits), then the blocks.
+*/
+size_t zfp_compress_capped(zfp_output *output, const zfp_input *input,
+                           zfp_cap *cap);
+
+/**
+ * @brief Decompress the blocks of a stream of zfp_compress_capped().
+ * @param cap Progress, advanced past the blocks decoded.
+ * @return Number of bytes read, 0 if the stream ends before the header word.
+*/
+size_t zfp_decompress_capped(zfp_output *output, const zfp_input *input,
+                             zfp_cap *cap);
+
+#endif // CAP_H
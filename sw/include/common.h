@@ -61,5 +61,11 @@ int exceeded_maxbits(uint maxbits, uint maxprec, uint size);
  * @return Maximum number of bit planes to encode.
 */
 uint get_precision(int maxexp, uint maxprec, int minexp, int dim);
+/**
+ * @brief Get the number of bits per value of a raw (untransformed) block.
+ * @return Bits of the two's complement block-floating-point integers,
+ *  between 0 and 31.
+*/
+uint get_raw_precision(int maxexp, uint maxprec, int minexp);
 
 #endif /* COMMON_H */
\ No newline at end of file
@@ -6,9 +6,85 @@
 #include "types.h"
 
 uint decode_fblock(zfp_output* output, float* fblock, size_t dim);
+/**
+ * @brief Move the stream past one block without decoding its values.
+ * @return Number of bits skipped, as decode_fblock().
+*/
+uint skip_fblock(zfp_output *output, size_t dim);
+/**
+ * @brief Decode a block of encode_adaptive_fblock() (decode_fblock() of an
+ *  adaptive output).
+ * @return Number of decoded bits.
+ * @note Adaptive blocks are skipped by decoding them: raw blocks have no
+ *  bit planes to skip over.
+*/
+uint decode_adaptive_fblock(zfp_output *output, float *fblock, size_t dim);
+/**
+ * @brief Decode the bit planes of a block whose header was read elsewhere.
+ * @return Number of bits decode_fblock() would count, header included.
+*/
+uint decode_fblock_bitplanes(zfp_output *output, float *fblock,
+                             uint biased_emax, size_t dim);
+/**
+ * @brief Decode a block up to its exponent and decorrelated coefficients.
+ * @param output Input stream and compression parameters.
+ * @param iblock Decoded coefficients relative to emax.
+ * @param emax Common block exponent (-EBIAS for an all-zero block).
+ * @param readprec Number of leading bit planes to keep (ZFP_MAX_PREC for all).
+ * @param dim Number of dimensions.
+ * @return Number of decoded bits, as decode_fblock().
+*/
+uint decode_coefficient_block(zfp_output *output, int32 *iblock, int *emax,
+                              uint readprec, size_t dim);
+uint decode_iblock(stream *const out_data, uint minbits, uint maxbits,
+                   uint maxprec, int32 *iblock, size_t dim);
+/**
+ * @brief Skip the code of the remaining bit planes of a block.
+ * @param s Input stream positioned at the next bit plane.
+ * @param planes Number of bit planes left in the block.
+ * @param n Number of coefficients found significant so far.
+ * @param block_size Number of coefficients.
+ * @return void
+ * @note Verbatim bits are skipped without being read, and once every
+ *  coefficient is significant, all remaining planes are skipped at once.
+*/
+void skip_bitplanes(stream *s, uint planes, uint n, uint block_size);
+
+/**
+ * @brief decode_iblock() without the inverse decorrelating transform.
+ * @note Only the leading readprec <= maxprec bit planes are kept; the rest of
+ *  the block is still consumed from the stream.
+*/
+uint decode_coefficients(stream *const out_data, uint minbits, uint maxbits,
+                         uint maxprec, uint readprec, int32 *iblock, size_t dim);
+void bwd_decorrelate_block(int32 *iblock, size_t dim);
+void bwd_cast_block(const int32 *iblock, float *fblock, uint n, int emax);
+/* Reorder, convert to signed and inverse-decorrelate a decoded block */
+void bwd_transform_iblock(const uint32 *ublock, int32 *iblock, size_t dim);
+void scatter_1d_block(const float *block, float *raw, ptrdiff_t sx);
+void scatter_partial_1d_block(const float *block, float *raw, size_t nx,
+                              ptrdiff_t sx);
 void scatter_2d_block(const float *block, float *raw,
                       ptrdiff_t sx, ptrdiff_t sy);
 void scatter_partial_2d_block(const float *block, float *raw,
                               size_t nx, size_t ny, ptrdiff_t sx, ptrdiff_t sy);
 
+/* Scatter the (possibly partial) block of a 1D/2D input at (x, y) */
+void scatter_input_block(const float *block, const zfp_input *input, size_t x,
+                         size_t y, size_t dim);
+
+/**
+ * @brief Accumulate a decoded block into the destination: raw += alpha * block.
+ * @note Fuses the scatter with the axpy so no decoded temporary is needed.
+*/
+void scatter_add_1d_block(const float *block, float *raw, float alpha,
+                          ptrdiff_t sx);
+void scatter_add_partial_1d_block(const float *block, float *raw, float alpha,
+                                  size_t nx, ptrdiff_t sx);
+void scatter_add_2d_block(const float *block, float *raw, float alpha,
+                          ptrdiff_t sx, ptrdiff_t sy);
+void scatter_add_partial_2d_block(const float *block, float *raw, float alpha,
+                                  size_t nx, size_t ny,
+                                  ptrdiff_t sx, ptrdiff_t sy);
+
 #endif // DECODE_H
\ No newline at end of file
@@ -0,0 +1,60 @@
+/* Exposed functions of delta.c */
+#ifndef DELTA_H
+#define DELTA_H
+
+#include <stddef.h>
+
+#include "types.h"
+
+/**
+ * @brief State shared (mirrored) by the encoder and decoder of a sequence of
+ *  tensors of the same shape, e.g., the gradients of one parameter across
+ *  training iterations.
+*/
+typedef struct {
+  size_t nx, ny;         /* shape of the tensors (ny = 0 for 1D) */
+  float *reference;      /* previous reconstructed tensor (contiguous) */
+  uint keyframe_interval; /* frames between keyframes (0: first frame only) */
+  size_t frame;          /* number of frames coded since the last keyframe */
+} zfp_delta;
+
+/**
+ * @brief Allocate the state of a delta-coded sequence.
+ * @param input Shape of the tensors (the data pointer is not used).
+ * @param keyframe_interval A keyframe is coded every keyframe_interval frames.
+ * @return State, freed with free_zfp_delta().
+*/
+zfp_delta *alloc_zfp_delta(const zfp_input *input, uint keyframe_interval);
+void free_zfp_delta(zfp_delta *state);
+
+/**
+ * @brief Code the next frame as a keyframe (e.g., after the receiver lost
+ *  its state).
+*/
+void reset_zfp_delta(zfp_delta *state);
+
+/**
+ * @brief Compress the next tensor of a sequence against the previous one.
+ * @param output Output stream and compression parameters.
+ * @param input Tensor of the current iteration.
+ * @param state Encoder state (updated to the decoder's reconstruction).
+ * @return Size of the compressed frame in bytes, as zfp_compress().
+ * @note A frame starts with a keyframe bit. Keyframes code the tensor,
+ *  other frames code its residual against the reconstructed previous
+ *  tensor. The reference is the reconstruction rather than the original, so
+ *  errors do not accumulate: every frame meets the tolerance on its own.
+*/
+size_t zfp_compress_delta(zfp_output *output, const zfp_input *input,
+                          zfp_delta *state);
+
+/**
+ * @brief Decompress the next tensor of a sequence.
+ * @param output Compressed frame and compression parameters.
+ * @param input Destination tensor.
+ * @param state Decoder state (updated, mirrors the encoder state).
+ * @return Number of bytes read, as zfp_decompress().
+*/
+size_t zfp_decompress_delta(zfp_output *output, const zfp_input *input,
+                            zfp_delta *state);
+
+#endif // DELTA_H
@@ -48,17 +48,49 @@ int get_block_exponent(const float *block, uint n);
 
 void fwd_cast_block(int32 *iblock, const float *fblock, uint n, int emax);
 
+void fwd_decorrelate_1d_block(int32 *iblock);
+
 void fwd_decorrelate_2d_block(int32 *iblock);
 
+/* Forward decorrelating transform of a 4^dim block */
+void fwd_decorrelate_block(int32 *iblock, size_t dim);
+
 void fwd_reorder_int2uint(uint32* ublock, const int32* iblock,
                           const uchar* perm, uint n);
 
+/**
+ * @brief Gather 4 float values from a strided 1D vector.
+ * @param block Pointer to the destination block.
+ * @param raw Pointer to the source array.
+ * @param sx Stride in the x dimension.
+ * @return void
+*/
+void gather_1d_block(float *block, const float *raw, ptrdiff_t sx);
+
+/**
+ * @brief Gather nx < 4 float values from a strided 1D vector and pad the
+ *  block to 4 values.
+*/
+void gather_partial_1d_block(float *block, const float *raw, size_t nx,
+                             ptrdiff_t sx);
+
 void gather_2d_block(float *block, const float *raw, ptrdiff_t sx,
                      ptrdiff_t sy);
 
 void gather_partial_2d_block(float *block, const float *raw,
                              size_t nx, size_t ny, ptrdiff_t sx, ptrdiff_t sy);
 
+/**
+ * @brief Gather the (possibly partial) block of a 1D/2D input at (x, y).
+ * @param block Pointer to the destination block.
+ * @param input Input array (strides of zero mean contiguous).
+ * @param x/y Index of the first value of the block (y = 0 for 1D).
+ * @param dim Number of dimensions.
+ * @return void
+*/
+void gather_input_block(float *block, const zfp_input *input, size_t x,
+                        size_t y, size_t dim);
+
 /**
  * @brief Get the maximum number of bit planes to encode.
  * @param maxexp Maximum block floating-point exponent.
@@ -72,11 +104,114 @@ uint get_precision(int maxexp, uint maxprec, int minexp, int dim);
 uint encode_all_bitplanes(stream *const s, const uint32 *const ublock,
                           uint maxprec, uint block_size);
 
+/**
+ * @brief encode_all_bitplanes() specialised for 1D/2D blocks.
+ * @return Number of bits written, the same bits as encode_all_bitplanes().
+ * @note Each bit plane is transposed (with SSE2 for 2D blocks) and its code
+ *  assembled in a register, then written with a single stream_write_bits().
+ *  Used whenever no bit budget applies, e.g., in fixed-precision mode where
+ *  every block codes the same maxprec planes.
+*/
+uint encode_precision_bitplanes(stream *const s, const uint32 *const ublock,
+                                uint maxprec, uint block_size);
+
 uint encode_partial_bitplanes(stream *const s,
                               const uint32 *const ublock,
                               uint maxbits, uint maxprec, uint block_size);
 
+/**
+ * @brief Truncate a block to the bit planes its embedded code would carry.
+ * @param ublock Reordered negabinary coefficients (truncated in place).
+ * @param maxbits Maximum number of bits to code.
+ * @param maxprec Maximum number of bit planes to code.
+ * @param block_size Number of coefficients.
+ * @return Number of bits encode_all/partial_bitplanes() would write.
+ * @note Nothing is written; ublock ends up holding exactly what the decoder
+ *  would deposit from those bits.
+*/
+uint truncate_bitplanes(uint32 *const ublock, uint maxbits, uint maxprec,
+                        uint block_size);
+
+/**
+ * @brief Count the embedded code length of a block for every precision.
+ * @param bits bits[p] receives the number of bits encode_all_bitplanes()
+ *  writes for p bit planes, for p = 0 to 32.
+ * @param ublock Reordered negabinary coefficients.
+ * @param block_size Number of coefficients.
+*/
+void get_bitplane_profile(uint *bits, const uint32 *const ublock,
+                          uint block_size);
+
+/**
+ * @brief Replace transformed coefficients by their decoded reconstruction.
+ * @param iblock Decorrelated coefficients in, reconstructed integers out.
+ * @return Number of bits the coefficients would be coded with.
+*/
+uint reconstruct_iblock(int32 *iblock, uint maxbits, uint maxprec, size_t dim);
+
+/**
+ * @brief Replace a block by its lossy reconstruction without coding it.
+ * @param output Compression parameters (the stream is not touched).
+ * @param fblock Block to round-trip in place.
+ * @param dim Number of dimensions.
+ * @return Number of bits encode_fblock() would write for the block.
+*/
+uint roundtrip_fblock(const zfp_output *output, float *fblock, size_t dim);
+
 uint encode_fblock(zfp_output* output, const float *fblock, size_t dim);
+
+/**
+ * @brief Encode a block and replace it by what the decoder will reconstruct.
+ * @return Number of encoded bits, as encode_fblock().
+ * @note Lets stateful encoders mirror the decoder without decoding the
+ *  stream back (see delta.c).
+*/
+uint encode_reconstruct_fblock(zfp_output *output, float *fblock, size_t dim);
+
+/**
+ * @brief Encode the bit planes of a block whose header (zero bit and
+ *  exponent) is written elsewhere.
+ * @param biased_emax Biased block exponent (0 for a block coded as zeros).
+ * @return Number of bits encode_fblock() would count, header included, so
+ *  the block keeps the bit budget of the regular layout.
+*/
+uint encode_fblock_bitplanes(zfp_output *output, const float *fblock,
+                             uint biased_emax, size_t dim);
 uint encode_iblock(stream *const out_data, uint minbits, uint maxbits,
                    uint maxprec, int32 *iblock, size_t dim);
+
+/**
+ * @brief Code already decorrelated coefficients (encode_iblock() without the
+ *  forward transform).
+*/
+uint encode_coefficients(stream *const out_data, uint minbits, uint maxbits,
+                         uint maxprec, const int32 *iblock, size_t dim);
+
+/**
+ * @brief Code a block given as common exponent and decorrelated coefficients.
+ * @param output Output stream and compression parameters.
+ * @param iblock Decorrelated coefficients relative to emax.
+ * @param emax Common block exponent (-EBIAS for an all-zero block).
+ * @param dim Number of dimensions.
+ * @return Number of encoded bits, as encode_fblock().
+*/
+uint encode_coefficient_block(zfp_output *output, const int32 *iblock,
+                              int emax, size_t dim);
+
+/**
+ * @brief Encode a block with the cheapest of the transform, raw and
+ *  constant codes (encode_fblock() of an adaptive output).
+ * @param recon Decoder reconstruction of the block (NULL to skip).
+ * @return Number of encoded bits.
+ * @note A nonzero block starts with a one-bit and a mode bit: 0 for the
+ *  regular transform code, 1 followed by 0 for raw and 1 for constant
+ *  blocks, then the exponent. Raw blocks store every block-floating-point
+ *  integer with get_raw_precision() bits, constant blocks a single one.
+ *  Raw coding is chosen when it is no longer than an estimate of the
+ *  embedded code (a leading-zero count per coefficient), which happens
+ *  for noise-like blocks the transform cannot compact. Rate-constrained
+ *  blocks that cannot store raw values in full keep the transform.
+*/
+uint encode_adaptive_fblock(zfp_output *output, const float *fblock,
+                            float *recon, size_t dim);
 #endif // ENCODE_H
\ No newline at end of file
@@ -0,0 +1,38 @@
+/* Exposed functions of eplane.c */
+#ifndef EPLANE_H
+#define EPLANE_H
+
+#include <stddef.h>
+
+#include "types.h"
+
+/**
+ * @brief Code the biased exponents of a bx*by grid of blocks.
+ * @param s Output stream.
+ * @param biased Biased exponent of each block in raster order (0 for a
+ *  block coded as all zeros).
+ * @param bx/by Number of blocks in x and y (by = 1 for 1D).
+ * @return Number of bits written.
+ * @note Each exponent is predicted from its left, upper and upper-left
+ *  neighbours (median edge detector) and the residual is coded with an
+ *  adaptive Rice code, so runs of equal or adjacent exponents cost about
+ *  1-3 bits instead of 1 + EBITS.
+*/
+uint64 encode_exponent_plane(stream *s, const uchar *biased, size_t bx,
+                             size_t by);
+uint64 decode_exponent_plane(stream *s, uchar *biased, size_t bx, size_t by);
+
+/**
+ * @brief Compress an array with all block exponents in a separate section.
+ * @param output Output stream and compression parameters.
+ * @param input Array to compress.
+ * @return Size of the compressed stream in bytes, as zfp_compress(), or 0
+ *  for an adaptive output (see set_zfp_output_adaptive()).
+ * @note The stream holds the exponent plane followed by the bit planes of
+ *  every block. Blocks keep the bit budget of the regular layout, so the
+ *  array decodes to the same values as a regular stream.
+*/
+size_t zfp_compress_eplane(zfp_output *output, const zfp_input *input);
+size_t zfp_decompress_eplane(zfp_output *output, const zfp_input *input);
+
+#endif // EPLANE_H
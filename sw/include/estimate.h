@@ -0,0 +1,41 @@
+/* Exposed functions of estimate.c */
+#ifndef ESTIMATE_H
+#define ESTIMATE_H
+
+#include <stddef.h>
+
+#include "types.h"
+
+/**
+ * @brief Estimate the compressed size of an array from a sample of blocks.
+ * @param output Compression parameters (the stream is not touched).
+ * @param input Array to compress.
+ * @param stride Blocks per stratum: one block of every stride consecutive
+ *  blocks is encoded (1: all blocks, exact).
+ * @param z Number of standard errors added to the estimate (e.g., 3 for a
+ *  one-sided 99.9% bound).
+ * @return Bytes to allocate, at most get_max_output_bytes().
+ * @note The sampled block of a stratum is picked by a hash of its index.
+ *  Each one is encoded into a scratch stream, so every mode and setting is
+ *  accounted for exactly. The bound is the sample mean plus z times its
+ *  standard error (with the finite population correction), scaled to all
+ *  blocks, plus one word for the final flush.
+*/
+size_t get_estimated_output_bytes(const zfp_output *output,
+                                  const zfp_input *input, size_t stride,
+                                  double z);
+
+/**
+ * @brief zfp_compress() into a buffer that grows when it runs out of room.
+ * @param output Output stream whose buffer comes from malloc().
+ * @param input Array to compress.
+ * @return Size of the compressed stream in bytes (0 if the buffer could not
+ *  be grown), as zfp_compress().
+ * @note Before each block the room left is checked against
+ *  get_max_block_bits(). If there is not enough, the buffer is doubled with
+ *  stream_resize(), so output->data->begin may move. The stream is the same
+ *  as zfp_compress() writes; no block index is recorded.
+*/
+size_t zfp_compress_growable(zfp_output *output, const zfp_input *input);
+
+#endif // ESTIMATE_H
@@ -0,0 +1,48 @@
+/* Exposed functions of feedback.c */
+#ifndef FEEDBACK_H
+#define FEEDBACK_H
+
+#include <stddef.h>
+
+#include "types.h"
+
+/**
+ * @brief Error-feedback state of one tensor across training iterations
+ *  (kept by the sender only).
+*/
+typedef struct {
+  size_t nx, ny;   /* shape of the tensor (ny = 0 for 1D) */
+  float *residual; /* input minus reconstruction of the last step */
+} zfp_feedback;
+
+/**
+ * @brief Allocate the error-feedback state of a tensor.
+ * @param input Shape of the tensor (the data pointer is not used).
+ * @return State with a zero residual, freed with free_zfp_feedback().
+*/
+zfp_feedback *alloc_zfp_feedback(const zfp_input *input);
+void free_zfp_feedback(zfp_feedback *state);
+
+/**
+ * @brief Clear the residual (e.g., when the receiver starts over).
+*/
+void reset_zfp_feedback(zfp_feedback *state);
+
+/**
+ * @brief Compress a tensor plus the residual of the previous step.
+ * @param output Output stream and compression parameters.
+ * @param input Tensor of the current step (not modified).
+ * @param state Residual, replaced by what this step failed to send.
+ * @return Size of the compressed stream in bytes, as zfp_compress().
+ * @note The stream is a regular stream of input + residual, read with
+ *  zfp_decompress(). Each block is coded by encode_reconstruct_fblock(),
+ *  which recovers the decoded block from the integers the encoder already
+ *  has, so the new residual comes out of the same pass without decoding.
+ *  Whatever is not sent is carried into the next step rather than lost:
+ *  summed over steps, the reconstructions differ from the inputs only by
+ *  the last residual.
+*/
+size_t zfp_compress_feedback(zfp_output *output, const zfp_input *input,
+                             zfp_feedback *state);
+
+#endif // FEEDBACK_H
@@ -0,0 +1,36 @@
+/* Exposed functions of lanes.c */
+#ifndef LANES_H
+#define LANES_H
+
+#include <stddef.h>
+
+#include "types.h"
+
+/* Maximum number of interleaved substreams */
+#define ZFP_MAX_LANES 64
+
+/**
+ * @brief Compress a 1D/2D array into interleaved substreams (lanes).
+ * @param output Output stream and compression parameters.
+ * @param input Array to compress.
+ * @param lanes Number of substreams (1 to ZFP_MAX_LANES).
+ * @return Size of the compressed stream in bytes, as zfp_compress().
+ * @note Blocks are assigned round robin to the lanes, like the hardware
+ *  encoder distributes them over its FIFO_WIDTH pipelines, and every lane
+ *  is coded as a regular stream. Word w of lane j is stored at word
+ *  lanes * w + j of the payload, so lanes can be read side by side.
+ *
+ *  Layout: the number of lanes and the number of words per lane (32 bits
+ *  each), then the payload. Shorter lanes are padded with zero words.
+*/
+size_t zfp_compress_lanes(zfp_output *output, const zfp_input *input,
+                          uint lanes);
+
+/**
+ * @brief Decompress a stream of zfp_compress_lanes().
+ * @note The lane readers advance in lockstep: each step decodes the next
+ *  block of every lane.
+*/
+size_t zfp_decompress_lanes(zfp_output *output, const zfp_input *input);
+
+#endif // LANES_H
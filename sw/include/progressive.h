@@ -0,0 +1,58 @@
+/* Exposed functions of progressive.c */
+#ifndef PROGRESSIVE_H
+#define PROGRESSIVE_H
+
+#include <stddef.h>
+
+#include "types.h"
+
+/**
+ * @brief Compress an array into a tensor-wide embedded (progressive) stream.
+ * @param output Output stream and compression parameters.
+ * @param input Array to compress.
+ * @return Size of the compressed stream in bytes, as zfp_compress(), or 0
+ *  for an adaptive output (see set_zfp_output_adaptive()).
+ * @note The stream holds the header (zero bit and exponent) of every block,
+ *  followed by bit planes in order of decreasing weight across the whole
+ *  array: plane 2^e of every block comes before plane 2^(e-1) of any block.
+ *  Each block's planes are coded exactly as encode_all_bitplanes() does, so
+ *  the stream has the same size as a regular accuracy/precision stream and
+ *  any prefix of it decodes to a coarser approximation. minbits and maxbits
+ *  are ignored: the rate is chosen by where the stream is cut.
+*/
+size_t zfp_compress_progressive(zfp_output *output, const zfp_input *input);
+
+/**
+ * @brief Decompress the first bytes of a progressive stream.
+ * @param output Compressed stream and compression parameters.
+ * @param input Destination array.
+ * @param bytes Number of bytes received (the buffer must be readable up to
+ *  the next word boundary).
+ * @return Number of bytes used (at most bytes), 0 for an adaptive output.
+ * @note Coefficients of the planes that have not arrived are zero, so the
+ *  error drops as bytes grows, and the whole stream decodes to the same array
+ *  as zfp_decompress() of a regular stream.
+*/
+size_t zfp_decompress_progressive(zfp_output *output, const zfp_input *input,
+                                  size_t bytes);
+
+/**
+ * @brief Progressive coding of an array of gathered 4^dim blocks.
+ * @param fblocks Blocks of BLOCK_SIZE(dim) values each.
+ * @param blocks Number of blocks.
+ * @return Number of bits written.
+*/
+uint64 encode_progressive_blocks(zfp_output *output, const float *fblocks,
+                                 size_t blocks, size_t dim);
+
+/**
+ * @brief Decode the first maxbits of a progressive stream of 4^dim blocks.
+ * @param fblocks Destination blocks of BLOCK_SIZE(dim) values each.
+ * @param blocks Number of blocks.
+ * @param maxbits Number of bits available to the decoder.
+ * @return Number of bits read (at most maxbits).
+*/
+uint64 decode_progressive_blocks(zfp_output *output, float *fblocks,
+                                 size_t blocks, size_t dim, uint64 maxbits);
+
+#endif // PROGRESSIVE_H
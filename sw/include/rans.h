@@ -0,0 +1,47 @@
+/* Exposed functions of rans.c */
+#ifndef RANS_H
+#define RANS_H
+
+#include <stddef.h>
+
+#include "types.h"
+
+/* Number of interleaved rANS states (a power of two) */
+#ifndef RANS_STATES
+#define RANS_STATES 4
+#endif
+/* Precision of the bit probabilities */
+#define RANS_PROB_BITS 12
+/* Adaptation rate of the bit probabilities (larger is slower) */
+#define RANS_ADAPT_SHIFT 5
+
+/**
+ * @brief Compress a 1D/2D array with the block bits entropy coded by rANS.
+ * @param output Output stream and compression parameters.
+ * @param input Array to compress.
+ * @return Size of the compressed stream in bytes, as zfp_compress(), or 0
+ *  for an adaptive output (see set_zfp_output_adaptive()).
+ * @note Every bit that encode_fblock() would write (zero-block flag,
+ *  exponent, verbatim bits, group tests and scan bits of each bit plane) is
+ *  instead coded by an adaptive binary rANS coder. Bit plane contexts are
+ *  keyed by the kind of bit, the plane index and n, so the mostly-zero
+ *  group tests of the low planes cost a fraction of a bit. RANS_STATES
+ *  states are interleaved round robin to break the dependency chain of the
+ *  decoder. The maxbits budget is applied to the uncoded bits, so the array
+ *  decodes to the same values as a regular stream; minbits padding is
+ *  dropped.
+ *
+ *  Layout: the number of 16-bit rANS words (64 bits), then the words.
+ *
+ *  Experimental: the layout trades speed for size and is not meant for
+ *  throughput-bound paths. Every coded bit costs about 6 ns to model and
+ *  another 6 ns to code, and smooth data codes 13-17 bits per value, so on
+ *  one 2.1 GHz core (-O2) it compresses and decompresses at 15-25 MB/s,
+ *  against 120-200 and 60-90 MB/s for the regular stream, and saves 10-16%
+ *  of the size. Hundreds of MB/s would take multi-bit symbols and another
+ *  stream format. The stream format may still change.
+*/
+size_t zfp_compress_rans(zfp_output *output, const zfp_input *input);
+size_t zfp_decompress_rans(zfp_output *output, const zfp_input *input);
+
+#endif // RANS_H
@@ -0,0 +1,40 @@
+/* Exposed functions of rate.c */
+#ifndef RATE_H
+#define RATE_H
+
+#include <stddef.h>
+
+#include "types.h"
+
+/**
+ * @brief Set a mean rate for zfp_compress_group_rate() with an error floor.
+ * @param output Output stream.
+ * @param rate Mean number of compressed bits per value.
+ * @param tolerance Absolute error at which a block stops taking bits (0 to
+ *  spend the whole budget).
+ * @param dim Number of dimensions of the array.
+ * @return Actual rate, as set_zfp_output_rate().
+*/
+double set_zfp_output_group_rate(zfp_output *output, double rate,
+                                 double tolerance, uint dim);
+
+/**
+ * @brief Compress a 1D/2D array with a bit budget shared by windows of blocks.
+ * @param output Output stream; maxbits is the mean budget per block and
+ *  maxprec/minexp still end a block early.
+ * @param input Array to compress.
+ * @param window Number of blocks per window (0: one row of blocks).
+ * @return Size of the compressed stream in bytes, as zfp_compress().
+ * @note A window of n blocks takes exactly n * maxbits bits (padded with
+ *  zeros). Each block is coded with the budget left in its window minus
+ *  maxbits for every block after it, so bits left over by smooth or zero
+ *  blocks go to the busy blocks that follow them, and no block gets fewer
+ *  bits than in fixed-rate mode. The decoder recomputes each cap from the
+ *  bits it has read, so no per-block sizes are stored.
+*/
+size_t zfp_compress_group_rate(zfp_output *output, const zfp_input *input,
+                               size_t window);
+size_t zfp_decompress_group_rate(zfp_output *output, const zfp_input *input,
+                                 size_t window);
+
+#endif // RATE_H
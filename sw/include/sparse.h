@@ -0,0 +1,45 @@
+/* Exposed functions of sparse.c */
+#ifndef SPARSE_H
+#define SPARSE_H
+
+#include <stddef.h>
+
+#include "types.h"
+
+/**
+ * @brief Flag the 4x4 blocks of a 2D input that encode_fblock() codes as
+ *  all zeros.
+ * @param bitmap One bit per block in raster order (bit b % 64 of word
+ *  b / 64), with room for get_input_num_blocks() bits.
+ * @param output Compression parameters (tolerance).
+ * @param input 2D input array.
+ * @return Number of flagged blocks.
+ * @note Blocks whose values are all below 2^(minexp - 2 * dim - 2) in
+ *  magnitude have no bit plane to code. Rows of contiguous inputs are
+ *  compared four values at a time with SSE2 when available. A flagged block
+ *  is always coded as zeros; the reverse may not hold for a few blocks at
+ *  the threshold, which the encoder still finds.
+*/
+size_t get_zero_block_bitmap(uint64 *bitmap, const zfp_output *output,
+                             const zfp_input *input);
+
+/**
+ * @brief Compress a 2D array with runs of zero blocks coded compactly.
+ * @param output Output stream and compression parameters.
+ * @param input Array to compress.
+ * @return Size of the compressed stream in bytes, as zfp_compress(), or 0
+ *  for an adaptive output (see set_zfp_output_adaptive()).
+ * @note Nonzero blocks are coded as by encode_fblock(). A run of L zero
+ *  blocks (in raster order) is coded as a zero bit followed by the Elias
+ *  gamma code of L. Blocks flagged by get_zero_block_bitmap() are never
+ *  gathered.
+*/
+size_t zfp_compress_sparse_2d(zfp_output *output, const zfp_input *input);
+
+/**
+ * @brief Decompress a stream of zfp_compress_sparse_2d().
+ * @note Zero runs are cleared with memset one row segment at a time.
+*/
+size_t zfp_decompress_sparse_2d(zfp_output *output, const zfp_input *input);
+
+#endif // SPARSE_H
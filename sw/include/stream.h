@@ -8,11 +8,8 @@ struct stream {
   stream_word buffer;   /* incoming/outgoing bits (buffer < 2^buffered_bits) */
   stream_word *begin;   /* beginning of stream */
   ptrdiff_t idx;     /* Index to next stream_word to be read/written */
-  ptrdiff_t end;     /* end of stream (not enforced) */
-// #ifdef BIT_STREAM_STRIDED
-//   size_t mask;           /* one less the block size in number of words */
-//   ptrdiff_t delta;       /* number of words between consecutive blocks */
-// #endif
+  ptrdiff_t end;     /* end of stream (words written past it are dropped) */
+  ptrdiff_t stride;  /* distance in words between consecutive stream words */
 };
 
 void stream_pad(stream *s, uint64 n);
@@ -21,15 +18,39 @@ void stream_write_word(stream *s, stream_word value);
 uint64 stream_read_bits(stream *s, size_t n);
 uint64 stream_write_bits(stream *s, uint64 value, size_t n);
 uint stream_read_bit(stream *s);
+/**
+ * @brief Skip up to limit zero-bits, plus the one-bit that ends them if it
+ *  comes within the limit.
+ * @return Number of zero-bits skipped (limit if no one-bit was found).
+*/
+uint stream_scan_zeros(stream *s, uint limit);
 uint stream_write_bit(stream *s, uint bit);
 uint64 stream_woffset(stream *s);
 void stream_rewind(stream *s);
+/**
+ * @brief Number of bytes written so far.
+ * @note Larger than stream_capacity_bytes() if words were dropped.
+*/
 size_t stream_size_bytes(const stream *s);
+size_t stream_capacity_bytes(const stream *s);
+/**
+ * @brief Reallocate the buffer of a contiguous stream, keeping its position.
+ * @param bytes New capacity (the buffer must come from malloc()).
+ * @return New buffer, or NULL (stream unchanged) if it cannot be allocated.
+*/
+stream_word *stream_resize(stream *s, size_t bytes);
 stream *stream_init(void* buffer, size_t bytes);
 size_t stream_flush(stream *s);
 uint64 stream_roffset(stream* s);
 void stream_rseek(stream* s, uint64 offset);
+void stream_wseek(stream* s, uint64 offset);
 void stream_skip(stream *s, uint64 n);
 size_t stream_algin_next_word(stream *s);
+/**
+ * @brief Interleave the stream with others at word granularity.
+ * @param stride Number of words from one stream word to the next (1 for a
+ *  contiguous stream). Offsets and sizes stay in stream words.
+*/
+void stream_set_stride(stream *s, ptrdiff_t stride);
 
 #endif /* STREAM_H */
\ No newline at end of file
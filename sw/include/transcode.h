@@ -0,0 +1,50 @@
+/* Exposed functions of transcode.c */
+#ifndef TRANSCODE_H
+#define TRANSCODE_H
+
+#include <stddef.h>
+
+#include "types.h"
+
+/**
+ * @brief Copy the embedded code of one block's coefficients to a coarser code.
+ * @param dst Output stream.
+ * @param src Input stream (positioned at the first coefficient bit).
+ * @param maxbits Maximum number of bits to write.
+ * @param maxprec Number of bit planes to write (<= srcprec).
+ * @param srcbits Maximum number of bits of the input block.
+ * @param srcprec Number of bit planes of the input block.
+ * @param block_size Number of coefficients.
+ * @return Number of bits written.
+ * @note Mirrors encode_partial_bitplanes(), but each bit plane is copied from
+ *  the input code instead of being extracted from coefficients. The output is
+ *  the prefix of the input code that a direct encode would have emitted, so
+ *  maxbits and maxprec must not exceed the input's. The input is left at the
+ *  end of its coded bits (minbits padding is not skipped).
+*/
+uint transcode_bitplanes(stream *dst, stream *src, uint maxbits, uint maxprec,
+                         uint srcbits, uint srcprec, uint block_size);
+
+/**
+ * @brief Transcode one block, header and coefficients.
+ * @return Number of bits written to dst (including padding).
+*/
+uint transcode_block(zfp_output *dst, zfp_output *src, size_t dim);
+
+/**
+ * @brief Re-emit a compressed array at a coarser tolerance, precision or rate.
+ * @param dst Output stream and (coarser) compression parameters.
+ * @param src Compressed array (positioned at its first block).
+ * @param input Shape of the array (the data pointer is not used).
+ * @return Size of the transcoded stream in bytes, as zfp_compress(), or 0
+ *  if either stream is adaptive (see set_zfp_output_adaptive()).
+ * @note The bit plane code is ordered from MSB to LSB, so each block is
+ *  truncated in the compressed domain without the integer or float
+ *  transforms. The parameters of dst are clamped to be no finer than those of
+ *  src, and the result is bit-identical to compressing the original array
+ *  with the clamped parameters. Fixed-rate to fixed-rate streams copy a
+ *  prefix of each block.
+*/
+size_t zfp_transcode(zfp_output *dst, zfp_output *src, const zfp_input *input);
+
+#endif // TRANSCODE_H
@@ -0,0 +1,58 @@
+/* Exposed functions of tune.c */
+#ifndef TUNE_H
+#define TUNE_H
+
+#include <stddef.h>
+
+#include "types.h"
+
+/* Fraction of the target below which a cached tolerance is retuned */
+#define ZFP_TUNE_SLACK 0.15
+
+/**
+ * @brief Tolerance cached for one tensor across training iterations.
+*/
+typedef struct {
+  size_t target_bytes; /* compressed size to stay under */
+  size_t stride;       /* one block out of stride is sampled */
+  size_t phase;        /* first sampled block, rotated on every call */
+  int minexp;          /* cached tolerance exponent */
+  uint tuned;          /* nonzero once minexp holds a tuned tolerance */
+  double predicted;    /* predicted size (bytes) at minexp, last call */
+  double scale;        /* measured / predicted size of past compressions */
+} zfp_tuner;
+
+/**
+ * @brief Allocate the tuner of a tensor.
+ * @param target_bytes Compressed size to meet.
+ * @param stride One block out of stride is sampled (1: all blocks).
+ * @return Tuner, freed with free_zfp_tuner().
+*/
+zfp_tuner *alloc_zfp_tuner(size_t target_bytes, size_t stride);
+void free_zfp_tuner(zfp_tuner *tuner);
+
+/**
+ * @brief Set the smallest tolerance whose compressed size meets the target.
+ * @param tuner Tuner of the tensor (updated).
+ * @param output Output stream, set to accuracy mode.
+ * @param input Tensor about to be compressed.
+ * @return Tolerance set, a power of two.
+ * @note The sampled blocks go through the regular transform, and
+ *  get_bitplane_profile() gives their code length at every precision. This
+ *  predicts the size at every tolerance for the cost of a single pass over
+ *  the samples. The cached tolerance is kept while its predicted size stays
+ *  between 1 - ZFP_TUNE_SLACK times the target and the target. Otherwise
+ *  the smallest power of two that meets the target is found by bisection,
+ *  so the setting follows the gradients as their magnitude drifts.
+*/
+double tune_zfp_output_accuracy(zfp_tuner *tuner, zfp_output *output,
+                                const zfp_input *input);
+
+/**
+ * @brief Correct the size model with the size of an actual compression.
+ * @param tuner Tuner used for the compression.
+ * @param bytes Size returned by zfp_compress().
+*/
+void update_zfp_tuner(zfp_tuner *tuner, size_t bytes);
+
+#endif // TUNE_H
@@ -35,6 +35,13 @@ typedef enum {
   zfp_reversible      = 5  /* reversible (lossless) mode */
 } zfp_mode;
 
+/* Coding mode of a block of an adaptive stream */
+typedef enum {
+  block_transform = 0, /* decorrelating transform and embedded coding */
+  block_raw       = 1, /* block-floating-point integers stored verbatim */
+  block_constant  = 2  /* a single block-floating-point integer */
+} block_mode;
+
 /* Data type */
 typedef enum {
   dtype_none   = 0, /* unspecified type */
@@ -55,16 +62,43 @@ typedef struct {
   ptrdiff_t sx, sy, sz, sw; /* stride of the array in the x/y/z/w dimension */
 } zfp_input;
 
+/* First word of the index header of a stream (ASCII "zfpindex") */
+#define ZFP_INDEX_MAGIC ((uint64)0x7a6670696e646578)
+
+/* Bit offsets of every granularity-th block of a compressed stream */
+typedef struct {
+  size_t granularity; /* number of blocks between recorded offsets */
+  size_t count;       /* number of recorded offsets */
+  uint64 *offsets;    /* stream offsets of blocks 0, granularity, ... */
+} zfp_index;
+
+/* Error statistics of the values coded by zfp_compress */
+typedef struct {
+  size_t count;       /* number of values */
+  double max_error;   /* maximum absolute error */
+  double sum_error2;  /* sum of squared errors */
+  float min, max;     /* range of the values */
+  double rmse;        /* root mean squared error */
+  double psnr;        /* 20 log10((max - min) / (2 rmse)), in dB */
+} zfp_stats;
+
 typedef struct {
   uint minbits;       /* minimum number of bits to store per block */
   uint maxbits;       /* maximum number of bits to store per block */
   uint maxprec;       /* maximum number of bit planes to store */
   int minexp;         /* minimum floating point bit plane number to store */
+  uint readprec;      /* maximum number of bit planes to decode (<= maxprec) */
   stream* data;       /* compressed bit stream */
+  zfp_index* index;   /* block offsets recorded by zfp_compress (optional) */
+  zfp_stats* stats;   /* error statistics computed by zfp_compress (optional) */
+  uint adaptive;      /* pick a coding mode per block (0: transform only) */
   // zfp_execution exec; /* execution policy and parameters */
 } zfp_output;
 
 
+//* Coefficients of a 1D block are already ordered by sequency.
+static const uchar PERM_1D[4] = {0, 1, 2, 3};
+
 #define index(i, j) ((i) + 4 * (j))
 //* Ordering coefficients (i, j) by i + j, then i^2 + j^2
 //* (Similar to the zig-zag ordering of JPEG.)
@@ -97,6 +131,10 @@ static const uchar PERM_2D[16] = {
 };
 #undef index
 
+/* Coefficient ordering of a 4^dim block: the one lookup shared by the
+   encoder, the decoder and the transform-domain operations */
+#define BLOCK_PERM(dim) ((dim) == 1 ? PERM_1D : PERM_2D)
+
 
 /**
  * @brief Set output accuracy parameters.
@@ -105,6 +143,89 @@ static const uchar PERM_2D[16] = {
  * @return Maximum error tolerance (x=1) for the given precision.
 */
 double set_zfp_output_accuracy(zfp_output *output, double tolerance);
+/**
+ * @brief Set output fixed-rate parameters.
+ * @param output Output stream.
+ * @param rate Number of compressed bits per value.
+ * @param dim Number of dimensions of the array.
+ * @return Actual rate (a whole number of bits per block).
+*/
+double set_zfp_output_rate(zfp_output *output, double rate, uint dim);
+/**
+ * @brief Set output fixed-precision parameters.
+ * @param output Output stream.
+ * @param precision Number of bit planes to encode per block.
+ * @return Actual precision (between 1 and ZFP_MAX_PREC).
+ * @note Every nonzero block codes the same number of bit planes, so errors
+ *  are relative to the largest magnitude of each block.
+*/
+uint set_zfp_output_precision(zfp_output *output, uint precision);
+/**
+ * @brief Get the compression mode the output parameters correspond to.
+ * @param output Output stream.
+ * @return zfp_expert unless the parameters are those of a setter above,
+ *  zfp_null if they are invalid.
+*/
+zfp_mode get_zfp_output_mode(const zfp_output *output);
+/**
+ * @brief Set the number of leading bit planes to decode per block.
+ * @param output Output stream.
+ * @param readprec Number of bit planes (ZFP_MAX_PREC decodes everything).
+ * @return Number of bit planes that will be decoded.
+ * @note Decoding stops after readprec planes and skips the rest of each
+ *  block, so decode time scales with readprec. Encoding is not affected.
+*/
+uint set_zfp_output_read_precision(zfp_output *output, uint readprec);
+/**
+ * @brief Choose between the transform, raw and constant codes per block.
+ * @param output Output stream.
+ * @param adaptive Nonzero to select a mode per block, zero for the regular
+ *  stream format.
+ * @return The new setting.
+ * @note Adaptive streams have a longer block header (see
+ *  encode_adaptive_fblock()). Only zfp_decompress() and the layouts that
+ *  code whole blocks with encode_fblock() and decode_fblock() read them;
+ *  zfp_roundtrip(), the transform-domain operations and the exponent
+ *  plane, sparse, progressive and rANS layouts parse the regular header
+ *  themselves and return 0.
+*/
+uint set_zfp_output_adaptive(zfp_output *output, uint adaptive);
+/**
+ * @brief Record the offset of every granularity-th block when compressing.
+ * @param output Output stream.
+ * @param input Shape of the array to compress.
+ * @param granularity Number of blocks between recorded offsets (e.g., the
+ *  number of blocks per row of blocks).
+ * @return Index filled by zfp_compress() (freed with the output).
+ * @note The index is stored in the stream: a word-aligned header holding
+ *  ZFP_INDEX_MAGIC, the granularity, then one word per recorded block but
+ *  the first with its bit offset from the end of the header. zfp_compress()
+ *  resizes the index to the shape it compresses. zfp_decompress() and
+ *  zfp_decompress_window_2d() look for the magic word at a word boundary
+ *  and load the header into output->index; an index set on a decoder makes
+ *  it align first, and is dropped if the stream has none. Fixed-rate
+ *  streams need no index to seek to a block.
+*/
+zfp_index *set_zfp_output_index(zfp_output *output, const zfp_input *input,
+                                size_t granularity);
+/**
+ * @brief Compute error statistics when compressing.
+ * @param output Output stream.
+ * @param enable Nonzero to compute them, zero to stop.
+ * @return Statistics filled by zfp_compress() (freed with the output), or
+ *  NULL once disabled.
+ * @note Each block is reconstructed from the integers the encoder already
+ *  has (see encode_reconstruct_fblock()), so no decompression is needed.
+*/
+zfp_stats *set_zfp_output_stats(zfp_output *output, uint enable);
+/**
+ * @brief Clear the statistics before a compression.
+*/
+void reset_zfp_stats(zfp_stats *stats);
+/**
+ * @brief Derive the RMSE and PSNR from the accumulated errors.
+*/
+void finish_zfp_stats(zfp_stats *stats);
 zfp_input *alloc_zfp_input(void);
 zfp_output *alloc_zfp_output(void);
 void free_zfp_input(zfp_input* input);
@@ -118,6 +239,11 @@ size_t get_input_num_blocks(const zfp_input* input);
 size_t get_input_size(const zfp_input* input, size_t* shape);
 size_t get_dtype_size(data_type dtype);
 uint get_input_precision(const zfp_input* input);
+/**
+ * @brief Get the maximum number of bits a block can be coded with.
+ * @return Bound of every block of the input, 0 for an unsupported input.
+*/
+uint get_max_block_bits(const zfp_output *output, const zfp_input *input);
 size_t get_max_output_bytes(const zfp_output *output, const zfp_input *input);
 
 #endif // TYPES_H
\ No newline at end of file
@@ -2,6 +2,52 @@
 
 
 size_t zfp_compress(zfp_output *output, const zfp_input *input);
+void zfp_compress_1d(zfp_output *output, const zfp_input *input);
 void zfp_compress_2d(zfp_output *output, const zfp_input *input);
 size_t zfp_decompress(zfp_output *output, const zfp_input *input);
-void zfp_decompress_2d(zfp_output *output, const zfp_input *input);
\ No newline at end of file
+void zfp_decompress_1d(zfp_output *output, const zfp_input *input);
+void zfp_decompress_2d(zfp_output *output, const zfp_input *input);
+
+/**
+ * @brief Decompress the window [x0, x0 + nx) x [y0, y0 + ny) of a 2D array.
+ * @param output Compressed stream (positioned at its first block).
+ * @param input Shape of the whole array (the data pointer is not used).
+ * @param x0/y0 Origin of the window in the array.
+ * @param window Destination of the window (data, nx, ny and strides).
+ * @return Number of decoded blocks.
+ * @note Only the blocks that intersect the window are decoded. Fixed-rate
+ *  streams seek to each block directly, other streams seek to the nearest
+ *  block of the index stored in the stream (read into output->index, see
+ *  set_zfp_output_index()) and skip the blocks in between without decoding
+ *  them. Without an index, blocks before the window are skipped from the
+ *  start of the stream.
+*/
+size_t zfp_decompress_window_2d(zfp_output *output, const zfp_input *input,
+                                size_t x0, size_t y0, const zfp_input *window);
+
+/**
+ * @brief Decompress and accumulate into the input: data += alpha * decoded.
+ * @param output Compressed stream and compression parameters.
+ * @param input Destination array (same shape as the compressed array).
+ * @param alpha Scale of the decoded values.
+ * @return Number of bytes read, as zfp_decompress().
+*/
+size_t zfp_decompress_accumulate(zfp_output *output, const zfp_input *input,
+                                 float alpha);
+void zfp_decompress_accumulate_1d(zfp_output *output, const zfp_input *input,
+                                  float alpha);
+void zfp_decompress_accumulate_2d(zfp_output *output, const zfp_input *input,
+                                  float alpha);
+
+/**
+ * @brief Replace the input by its compress-then-decompress reconstruction.
+ * @param output Compression parameters (the stream is not written).
+ * @param input Array to round-trip in place.
+ * @return Number of bits zfp_compress() would emit (before word alignment),
+ *  0 for an adaptive output.
+ * @note Each block goes gather -> cast -> lift -> reorder -> truncation ->
+ *  inverse transforms -> scatter in a single pass, without a bitstream.
+*/
+size_t zfp_roundtrip(const zfp_output *output, const zfp_input *input);
+size_t zfp_roundtrip_1d(const zfp_output *output, const zfp_input *input);
+size_t zfp_roundtrip_2d(const zfp_output *output, const zfp_input *input);
\ No newline at end of file
@@ -0,0 +1,180 @@
+// Description: Arithmetic on compressed arrays in the transform domain.
+// Documentation: ./include/algebra.h
+
+#include <stddef.h>
+#include <stdio.h>
+#include <math.h>
+
+#include "algebra.h"
+#include "decode.h"
+#include "encode.h"
+#include "stream.h"
+
+
+/* Scale coefficients from exponent e to emax >= e */
+static int64 align_coefficient(int32 c, int e, int emax)
+{
+  int shift = emax - e;
+  return shift < (int)(CHAR_BIT * sizeof(int32)) ? (int64)c >> shift : 0;
+}
+
+/**
+ * @brief Add two blocks of decorrelated coefficients.
+ * @return Common exponent of the sum (-EBIAS if the sum is all zeros).
+ * @note The cast keeps |value| < 2^30 and the lifting steps do not expand
+ *  that range, so the sum is renormalized by one bit if it reaches 2^30.
+*/
+static int add_coefficients(int32 *sum, const int32 *a, int ea,
+                            const int32 *b, int eb, uint n)
+{
+  int emax = MAX(ea, eb);
+  int64 s[BLOCK_SIZE_4D];
+  int64 max = 0;
+  uint i;
+  for (i = 0; i < n; i++) {
+    s[i] = align_coefficient(a[i], ea, emax) + align_coefficient(b[i], eb, emax);
+    int64 m = s[i] < 0 ? -s[i] : s[i];
+    max = MAX(max, m);
+  }
+  if (!max)
+    return -EBIAS;
+  uint shift = max >= ((int64)1 << 30) ? 1 : 0;
+  for (i = 0; i < n; i++)
+    sum[i] = (int32)(s[i] >> shift);
+  return emax + (int)shift;
+}
+
+size_t zfp_add(zfp_output *output, zfp_output *a, zfp_output *b,
+               const zfp_input *input)
+{
+  if (output->adaptive || a->adaptive || b->adaptive)
+    //* Only decode_fblock() reads the block header of adaptive streams.
+    return 0;
+  size_t dim = get_input_dimension(input);
+  size_t num_blocks = get_input_num_blocks(input);
+  uint block_size = BLOCK_SIZE(dim);
+  int32 ablock[block_size], bblock[block_size], sblock[block_size];
+
+  //* Both streams hold the blocks in the same order, whatever the shape.
+  for (size_t i = 0; i < num_blocks; i++) {
+    int ea, eb;
+    decode_coefficient_block(a, ablock, &ea, ZFP_MAX_PREC, dim);
+    decode_coefficient_block(b, bblock, &eb, ZFP_MAX_PREC, dim);
+    int emax = add_coefficients(sblock, ablock, ea, bblock, eb, block_size);
+    encode_coefficient_block(output, sblock, emax, dim);
+  }
+
+  stream_flush(output->data);
+  return stream_size_bytes(output->data);
+}
+
+/* Scale of the integers of a block with exponent emax */
+static double get_block_scale(int emax)
+{
+  return ldexp(1.0, emax - ((int)(CHAR_BIT * sizeof(float)) - 2));
+}
+
+/**
+ * @brief Bound the value error of a block whose planes below readprec were
+ *  dropped.
+ * @note A truncated negabinary coefficient is off by less than 2^kread, and
+ *  each inverse lift grows the max-norm by at most (4 + 6 + 4 + 1) / 4.
+*/
+static double get_truncation_error(int emax, uint maxprec, uint readprec,
+                                   size_t dim)
+{
+  uint intprec = (uint)(CHAR_BIT * sizeof(int32));
+  if (readprec >= maxprec)
+    return 0;
+  double gain = dim == 1 ? 3.75 : 3.75 * 3.75;
+  return gain * ldexp(1.0, (int)(intprec - readprec)) * get_block_scale(emax);
+}
+
+/* Decode the next block to integers (inverse transform, no cast) */
+static uint decode_reduced_block(zfp_output *output, int32 *iblock, int *emax,
+                                 uint readprec, size_t dim, double *error)
+{
+  uint bits = decode_coefficient_block(output, iblock, emax, readprec, dim);
+  bwd_decorrelate_block(iblock, dim);
+  uint maxprec = get_precision(*emax, output->maxprec, output->minexp, dim);
+  if (*emax != -EBIAS)
+    *error = get_truncation_error(*emax, maxprec, readprec, dim);
+  else
+    *error = 0;
+  return bits;
+}
+
+void zfp_reduce(zfp_output *output, const zfp_input *input, uint readprec,
+                zfp_reduction *r)
+{
+  size_t dim = get_input_dimension(input);
+  uint block_size = BLOCK_SIZE(dim);
+  size_t nx = input->nx;
+  size_t ny = dim > 1 ? input->ny : 1;
+  int32 iblock[block_size];
+  double error = 0;
+
+  r->count = 0;
+  r->sum = r->sumsq = r->error = 0;
+  if (output->adaptive)
+    //* Only decode_fblock() reads the block header of adaptive streams.
+    return;
+  //* Reduce one block at a time, keeping only the values inside the array.
+  for (size_t y = 0; y < ny; y += 4) {
+    size_t by = dim > 1 ? MIN(ny - y, 4u) : 1;
+    for (size_t x = 0; x < nx; x += 4) {
+      size_t bx = MIN(nx - x, 4u);
+      int emax;
+      double e;
+      decode_reduced_block(output, iblock, &emax, readprec, dim, &e);
+      int64 sum = 0;
+      double sumsq = 0;
+      for (size_t j = 0; j < by; j++)
+        for (size_t i = 0; i < bx; i++) {
+          int32 v = iblock[4 * j + i];
+          sum += v;
+          sumsq += (double)v * v;
+        }
+      double scale = get_block_scale(emax);
+      r->sum += scale * sum;
+      r->sumsq += scale * scale * sumsq;
+      r->count += bx * by;
+      error += e * e * bx * by;
+    }
+  }
+  r->error = sqrt(error);
+  stream_algin_next_word(output->data);
+}
+
+double zfp_dot(zfp_output *a, zfp_output *b, const zfp_input *input,
+               uint readprec)
+{
+  if (a->adaptive || b->adaptive)
+    //* Only decode_fblock() reads the block header of adaptive streams.
+    return 0;
+  size_t dim = get_input_dimension(input);
+  uint block_size = BLOCK_SIZE(dim);
+  size_t nx = input->nx;
+  size_t ny = dim > 1 ? input->ny : 1;
+  int32 ablock[block_size], bblock[block_size];
+  double dot = 0;
+
+  for (size_t y = 0; y < ny; y += 4) {
+    size_t by = dim > 1 ? MIN(ny - y, 4u) : 1;
+    for (size_t x = 0; x < nx; x += 4) {
+      size_t bx = MIN(nx - x, 4u);
+      int ea, eb;
+      double e;
+      decode_reduced_block(a, ablock, &ea, readprec, dim, &e);
+      decode_reduced_block(b, bblock, &eb, readprec, dim, &e);
+      double sum = 0;
+      for (size_t j = 0; j < by; j++)
+        for (size_t i = 0; i < bx; i++)
+          sum += (double)ablock[4 * j + i] * bblock[4 * j + i];
+      dot += get_block_scale(ea) * get_block_scale(eb) * sum;
+    }
+  }
+  stream_algin_next_word(a->data);
+  stream_algin_next_word(b->data);
+  return dot;
+}
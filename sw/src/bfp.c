@@ -0,0 +1,109 @@
+// Description: Block-floating-point layout without transform or bit planes.
+// Documentation: ./include/bfp.h
+
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "bfp.h"
+#include "decode.h"
+#include "encode.h"
+#include "stream.h"
+
+
+uint get_bfp_precision(const zfp_output *output)
+{
+  return MIN(MAX(output->maxprec, 1u), 31u);
+}
+
+/* Append the low n < 64 bits of value (no higher bits set) */
+static inline void put_bits(stream *s, uint64 value, uint n)
+{
+  s->buffer += value << s->buffered_bits;
+  s->buffered_bits += n;
+  if (s->buffered_bits >= SWORD_BITS) {
+    s->buffered_bits -= SWORD_BITS;
+    stream_write_word(s, s->buffer);
+    s->buffer = s->buffered_bits ? value >> (n - s->buffered_bits) : 0;
+  }
+}
+
+/* Read the next 0 < n < 64 bits */
+static inline uint64 get_bits(stream *s, uint n)
+{
+  uint64 value = s->buffer;
+  if (s->buffered_bits < n) {
+    s->buffer = stream_read_word(s);
+    value += s->buffer << s->buffered_bits;
+    s->buffer >>= n - s->buffered_bits;
+    s->buffered_bits += SWORD_BITS - n;
+  } else {
+    s->buffer >>= n;
+    s->buffered_bits -= n;
+  }
+  return value & (((uint64)1 << n) - 1);
+}
+
+size_t zfp_compress_bfp(zfp_output *output, const zfp_input *input)
+{
+  size_t dim = get_input_dimension(input);
+  if (dim < 1 || dim > 2)
+    //TODO: Implement other dimensions.
+    return 0;
+  uint block_size = BLOCK_SIZE(dim);
+  uint p = get_bfp_precision(output);
+  uint shift = 31 - p;
+  uint32 mask = ((uint32)1 << p) - 1;
+  size_t bx = (input->nx + 3) / 4;
+  size_t blocks = get_input_num_blocks(input);
+  stream *s = output->data;
+  float fblock[BLOCK_SIZE_2D];
+  int32 iblock[BLOCK_SIZE_2D];
+
+  for (size_t b = 0; b < blocks; b++) {
+    gather_input_block(fblock, input, 4 * (b % bx), 4 * (b / bx), dim);
+    int emax = get_block_exponent(fblock, block_size);
+    fwd_cast_block(iblock, fblock, block_size, emax);
+    put_bits(s, (uint64)(emax + EBIAS), EBITS);
+    //* Two values (at most 62 bits) per write.
+    for (uint i = 0; i < block_size; i += 2)
+      put_bits(s, ((uint32)(iblock[i] >> shift) & mask) |
+                  (uint64)((uint32)(iblock[i + 1] >> shift) & mask) << p,
+               2 * p);
+  }
+
+  stream_flush(s);
+  return stream_size_bytes(s);
+}
+
+size_t zfp_decompress_bfp(zfp_output *output, const zfp_input *input)
+{
+  size_t dim = get_input_dimension(input);
+  if (dim < 1 || dim > 2)
+    //TODO: Implement other dimensions.
+    return 0;
+  uint block_size = BLOCK_SIZE(dim);
+  uint p = get_bfp_precision(output);
+  uint shift = 31 - p;
+  int32 half = shift ? (int32)1 << (shift - 1) : 0;
+  size_t bx = (input->nx + 3) / 4;
+  size_t blocks = get_input_num_blocks(input);
+  stream *s = output->data;
+  float fblock[BLOCK_SIZE_2D];
+  int32 iblock[BLOCK_SIZE_2D];
+
+  for (size_t b = 0; b < blocks; b++) {
+    int emax = (int)get_bits(s, EBITS) - EBIAS;
+    //* Sign-extend from the top of the word and reconstruct at the midpoint.
+    for (uint i = 0; i < block_size; i += 2) {
+      uint64 pair = get_bits(s, 2 * p);
+      iblock[i] = ((int32)((uint32)pair << (32 - p)) >> 1) + half;
+      iblock[i + 1] = ((int32)((uint32)(pair >> p) << (32 - p)) >> 1) + half;
+    }
+    bwd_cast_block(iblock, fblock, block_size, emax);
+    scatter_input_block(fblock, input, 4 * (b % bx), 4 * (b / bx), dim);
+  }
+
+  stream_algin_next_word(s);
+  return stream_size_bytes(s);
+}
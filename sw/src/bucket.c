@@ -0,0 +1,183 @@
+// Description: Packing of small gradient tensors into 2D compression buckets.
+// Documentation: ./include/bucket.h
+
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "bucket.h"
+
+
+/* Round n up to the next multiple of 4 (the block edge) */
+static size_t round_up_block(size_t n)
+{
+  return (n + 3) & ~(size_t)3;
+}
+
+/* Number of bucket rows spanned by one row of `cols` values */
+static size_t get_wrap(size_t cols, size_t nx)
+{
+  return cols ? (cols + nx - 1) / nx : 1;
+}
+
+/* Number of (block-aligned) bucket rows needed for tensors [first, last) */
+static size_t get_bucket_rows(const zfp_tensor *tensors, size_t first,
+                              size_t last, size_t nx)
+{
+  size_t rows = 0;
+  for (size_t i = first; i < last; i++)
+    rows += tensors[i].rows * get_wrap(tensors[i].cols, nx);
+  return round_up_block(rows);
+}
+
+/* Keep nx as the best bucket width if it needs fewer padded values */
+static void try_bucket_width(size_t *best_nx, size_t *best_area,
+                             const zfp_tensor *tensors, size_t first,
+                             size_t last, size_t nx)
+{
+  size_t ny = get_bucket_rows(tensors, first, last, nx);
+  size_t area = nx * ny;
+  //* Ties go to the squarer shape.
+  if (area < *best_area || (area == *best_area && MAX(nx, ny) < MAX(*best_nx,
+                            *best_area / *best_nx))) {
+    *best_nx = nx;
+    *best_area = area;
+  }
+}
+
+/**
+ * @brief Pick the bucket width that needs the fewest padded values.
+ * @note Candidates are the (rounded) row lengths of the tensors, which keep
+ *  rows intact, and powers of two up to the longest row, which let long 1D
+ *  tensors (bias, BatchNorm) fold into many rows instead of a single row
+ *  padded to 4.
+*/
+static size_t get_bucket_width(const zfp_tensor *tensors, size_t first,
+                               size_t last)
+{
+  size_t maxcols = 4;
+  for (size_t i = first; i < last; i++)
+    maxcols = MAX(maxcols, round_up_block(tensors[i].cols));
+
+  size_t best_nx = maxcols;
+  size_t best_area = (size_t)-1;
+  for (size_t i = first; i < last; i++)
+    if (tensors[i].cols)
+      try_bucket_width(&best_nx, &best_area, tensors, first, last,
+                       round_up_block(tensors[i].cols));
+  for (size_t nx = 4; nx <= maxcols; nx <<= 1)
+    try_bucket_width(&best_nx, &best_area, tensors, first, last, nx);
+  return best_nx;
+}
+
+static void init_zfp_bucket(zfp_bucket *bucket, const zfp_tensor *tensors,
+                            size_t first, size_t last)
+{
+  size_t nx = get_bucket_width(tensors, first, last);
+  bucket->nx = nx;
+  bucket->count = last - first;
+  bucket->slots = (zfp_bucket_slot*)malloc(bucket->count * sizeof(
+                    zfp_bucket_slot));
+  size_t y = 0;
+  for (size_t i = first; i < last; i++) {
+    zfp_bucket_slot *slot = bucket->slots + (i - first);
+    slot->tensor = i;
+    slot->y = y;
+    slot->wrap = get_wrap(tensors[i].cols, nx);
+    y += tensors[i].rows * slot->wrap;
+  }
+  bucket->used = y;
+  bucket->ny = round_up_block(y);
+}
+
+zfp_bucket_layout *plan_zfp_buckets(const zfp_tensor *tensors, size_t count,
+                                    size_t capacity)
+{
+  zfp_bucket_layout *layout = (zfp_bucket_layout*)malloc(sizeof(
+                                zfp_bucket_layout));
+  if (!layout)
+    return NULL;
+  //* At most one bucket per tensor.
+  layout->buckets = (zfp_bucket*)malloc(MAX(count, 1u) * sizeof(zfp_bucket));
+  layout->num_buckets = 0;
+
+  //* Greedily fill each bucket in tensor order up to its capacity.
+  for (size_t first = 0, last = 0; first < count; first = last) {
+    size_t size = tensors[last].rows * tensors[last].cols;
+    for (last++; last < count; last++) {
+      size_t next = tensors[last].rows * tensors[last].cols;
+      if (size + next > capacity)
+        break;
+      size += next;
+    }
+    init_zfp_bucket(layout->buckets + layout->num_buckets++, tensors, first,
+                    last);
+  }
+  return layout;
+}
+
+void free_zfp_bucket_layout(zfp_bucket_layout *layout)
+{
+  if (!layout)
+    return;
+  for (size_t b = 0; b < layout->num_buckets; b++)
+    free(layout->buckets[b].slots);
+  free(layout->buckets);
+  free(layout);
+}
+
+void pack_zfp_bucket(float *dst, const zfp_bucket *bucket,
+                     const zfp_tensor *tensors)
+{
+  size_t nx = bucket->nx;
+  for (size_t s = 0; s < bucket->count; s++) {
+    const zfp_bucket_slot *slot = bucket->slots + s;
+    const zfp_tensor *t = tensors + slot->tensor;
+    float *row = dst + nx * slot->y;
+    for (size_t r = 0; r < t->rows; r++) {
+      const float *src = t->data + t->cols * r;
+      //* Split a long tensor row into segments of nx values.
+      for (size_t x = 0; x < t->cols; x += nx, row += nx) {
+        size_t n = MIN(nx, t->cols - x);
+        memcpy(row, src + x, n * sizeof(float));
+        //* Pad the segment with its last value (cheap to decorrelate).
+        for (size_t i = n; i < nx; i++)
+          row[i] = row[n - 1];
+      }
+      //* An empty row still occupies one bucket row.
+      if (!t->cols) {
+        memset(row, 0, nx * sizeof(float));
+        row += nx;
+      }
+    }
+  }
+  //* Pad the bucket to a multiple of 4 rows by repeating the last used row.
+  for (size_t y = bucket->used; y < bucket->ny; y++) {
+    if (y)
+      memcpy(dst + nx * y, dst + nx * (y - 1), nx * sizeof(float));
+    else
+      memset(dst, 0, nx * sizeof(float));
+  }
+}
+
+void unpack_zfp_bucket(const float *src, const zfp_bucket *bucket,
+                       const zfp_tensor *tensors)
+{
+  size_t nx = bucket->nx;
+  for (size_t s = 0; s < bucket->count; s++) {
+    const zfp_bucket_slot *slot = bucket->slots + s;
+    const zfp_tensor *t = tensors + slot->tensor;
+    const float *row = src + nx * slot->y;
+    for (size_t r = 0; r < t->rows; r++, row += nx * slot->wrap) {
+      float *dst = t->data + t->cols * r;
+      for (size_t x = 0, w = 0; x < t->cols; x += nx, w++)
+        memcpy(dst + x, row + nx * w, MIN(nx, t->cols - x) * sizeof(float));
+    }
+  }
+}
+
+zfp_input *init_zfp_bucket_input(float *data, const zfp_bucket *bucket)
+{
+  return init_zfp_input(data, dtype_float, 2, (uint)bucket->nx,
+                        (uint)bucket->ny);
+}
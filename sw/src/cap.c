@@ -0,0 +1,162 @@
+// Description: Compression into byte-capped buffers with overflow handling.
+// Documentation: ./include/cap.h
+
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "cap.h"
+#include "decode.h"
+#include "encode.h"
+#include "stream.h"
+
+
+zfp_cap *alloc_zfp_cap(zfp_overflow overflow)
+{
+  zfp_cap *cap = (zfp_cap*)malloc(sizeof(zfp_cap));
+  if (cap) {
+    cap->overflow = overflow;
+    reset_zfp_cap(cap);
+  }
+  return cap;
+}
+
+void free_zfp_cap(zfp_cap *cap)
+{
+  free(cap);
+}
+
+void reset_zfp_cap(zfp_cap *cap)
+{
+  cap->block = 0;
+  cap->fallback_bits = 0;
+}
+
+/* Settings of the fixed-rate tail */
+static zfp_output get_fallback_output(const zfp_output *output, uint bits)
+{
+  zfp_output tail = *output;
+  tail.minbits = tail.maxbits = bits;
+  tail.maxprec = ZFP_MAX_PREC;
+  tail.minexp = ZFP_MIN_EXP;
+  tail.adaptive = 0;
+  tail.index = NULL;
+  return tail;
+}
+
+size_t zfp_compress_capped(zfp_output *output, const zfp_input *input,
+                           zfp_cap *cap)
+{
+  size_t dim = get_input_dimension(input);
+  if (dim < 1 || dim > 2)
+    //TODO: Implement other dimensions.
+    return 0;
+  size_t bx = (input->nx + 3) / 4;
+  size_t blocks = get_input_num_blocks(input);
+  stream *s = output->data;
+  uint64 capacity = (uint64)s->end * SWORD_BITS;
+  float fblock[BLOCK_SIZE_2D];
+  size_t b = cap->block;
+
+  //* The header word is written once the block counts are known.
+  stream_flush(s);
+  uint64 header = stream_woffset(s);
+  if (header + SWORD_BITS > capacity)
+    //* Not even the header word fits, so nothing is written.
+    return 0;
+  stream_pad(s, SWORD_BITS);
+  uint reserve = 0;
+  if (cap->overflow == zfp_overflow_fixed_rate && b < blocks) {
+    //* Half the mean budget is kept for every block left, so a tail coded
+    //* at a fixed rate is still at half the mean rate or more.
+    uint64 room = capacity > stream_woffset(s) ?
+                  capacity - stream_woffset(s) : 0;
+    reserve = (uint)MIN(room / (blocks - b) / 2, (uint64)ZFP_MAX_BITS);
+    reserve = MAX(reserve, 1u + EBITS);
+  }
+  //* Encode normally and only act once a block crosses the cap.
+  uint64 *offsets = (uint64*)malloc((blocks - b + 1) * sizeof(uint64));
+  size_t first = b;
+  for (; b < blocks; b++) {
+    offsets[b - first] = stream_woffset(s);
+    gather_input_block(fblock, input, 4 * (b % bx), 4 * (b / bx), dim);
+    encode_fblock(output, fblock, dim);
+    if (stream_woffset(s) > capacity)
+      break;
+  }
+  if (b < blocks) {
+    //* Back to the latest block that leaves reserve bits to each block after
+    //* it (the block that crossed the cap without a fallback). Words past
+    //* the end were dropped; the rest is rewritten.
+    while (b > first && offsets[b - first] + (uint64)(blocks - b) * reserve >
+           capacity)
+      b--;
+    stream_wseek(s, offsets[b - first]);
+  }
+  free(offsets);
+  size_t regular = b - cap->block;
+
+  uint bits = 0;
+  if (b < blocks && reserve && stream_woffset(s) <= capacity) {
+    uint64 room = (capacity - stream_woffset(s)) / (blocks - b);
+    bits = (uint)MIN(room, (uint64)ZFP_MAX_BITS);
+    if (bits < 1 + EBITS)
+      bits = 0;
+  }
+  if (bits) {
+    zfp_output tail = get_fallback_output(output, bits);
+    for (; b < blocks; b++) {
+      gather_input_block(fblock, input, 4 * (b % bx), 4 * (b / bx), dim);
+      encode_fblock(&tail, fblock, dim);
+    }
+  }
+  cap->block = b;
+  cap->fallback_bits = bits;
+
+  stream_flush(s);
+  uint64 end = stream_woffset(s);
+  stream_wseek(s, header);
+  stream_write_bits(s, regular & 0xffffffffu, 32);
+  stream_write_bits(s, ((uint64)regular >> 32 & 0xffffu) | (uint64)bits << 16,
+                    32);
+  stream_wseek(s, end);
+  return stream_size_bytes(s);
+}
+
+size_t zfp_decompress_capped(zfp_output *output, const zfp_input *input,
+                             zfp_cap *cap)
+{
+  size_t dim = get_input_dimension(input);
+  if (dim < 1 || dim > 2)
+    //TODO: Implement other dimensions.
+    return 0;
+  size_t bx = (input->nx + 3) / 4;
+  size_t blocks = get_input_num_blocks(input);
+  stream *s = output->data;
+  float fblock[BLOCK_SIZE_2D];
+  size_t b = cap->block;
+
+  stream_algin_next_word(s);
+  if (stream_roffset(s) + SWORD_BITS > (uint64)s->end * SWORD_BITS)
+    return 0;
+  size_t regular = (size_t)stream_read_bits(s, 32);
+  uint64 high = stream_read_bits(s, 32);
+  regular += (size_t)(high & 0xffffu) << 32;
+  uint bits = (uint)(high >> 16);
+  for (size_t end = MIN(b + regular, blocks); b < end; b++) {
+    decode_fblock(output, fblock, dim);
+    scatter_input_block(fblock, input, 4 * (b % bx), 4 * (b / bx), dim);
+  }
+  if (bits) {
+    zfp_output tail = get_fallback_output(output, bits);
+    for (; b < blocks; b++) {
+      decode_fblock(&tail, fblock, dim);
+      scatter_input_block(fblock, input, 4 * (b % bx), 4 * (b / bx), dim);
+    }
+  }
+  cap->block = b;
+  cap->fallback_bits = bits;
+
+  stream_algin_next_word(s);
+  return stream_size_bytes(s);
+}
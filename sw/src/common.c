@@ -20,6 +20,106 @@ double set_zfp_output_accuracy(zfp_output *output, double tolerance)
   return tolerance > 0 ? LDEXP(1.0, emin) : 0;
 }
 
+double set_zfp_output_rate(zfp_output *output, double rate, uint dim)
+{
+  uint bits = (uint)floor(BLOCK_SIZE(dim) * rate + 0.5);
+  output->minbits = output->maxbits = MIN(MAX(bits, 1u), ZFP_MAX_BITS);
+  output->maxprec = ZFP_MAX_PREC;
+  output->minexp = ZFP_MIN_EXP;
+  //* Returns the rate that fits a whole number of bits per block.
+  return (double)output->maxbits / BLOCK_SIZE(dim);
+}
+
+uint set_zfp_output_precision(zfp_output *output, uint precision)
+{
+  output->minbits = ZFP_MIN_BITS;
+  output->maxbits = ZFP_MAX_BITS;
+  output->maxprec = MIN(MAX(precision, 1u), ZFP_MAX_PREC);
+  output->minexp = ZFP_MIN_EXP;
+  return output->maxprec;
+}
+
+zfp_mode get_zfp_output_mode(const zfp_output *output)
+{
+  if (output->minbits > output->maxbits || !output->maxprec ||
+      output->maxprec > ZFP_MAX_PREC)
+    return zfp_null;
+  uint unbounded = output->minbits <= ZFP_MIN_BITS &&
+                   output->maxbits >= ZFP_MAX_BITS;
+  //* Checked in this order, as the modes share some parameter values.
+  if (output->minbits == output->maxbits && output->maxbits <= ZFP_MAX_BITS &&
+      output->maxprec == ZFP_MAX_PREC && output->minexp == ZFP_MIN_EXP)
+    return zfp_fixed_rate;
+  if (unbounded && output->minexp == ZFP_MIN_EXP)
+    return zfp_fixed_precision;
+  if (unbounded && output->maxprec == ZFP_MAX_PREC)
+    return is_reversible(output) ? zfp_reversible : zfp_fixed_accuracy;
+  return zfp_expert;
+}
+
+uint set_zfp_output_read_precision(zfp_output *output, uint readprec)
+{
+  output->readprec = MIN(MAX(readprec, 1u), ZFP_MAX_PREC);
+  return output->readprec;
+}
+
+uint set_zfp_output_adaptive(zfp_output *output, uint adaptive)
+{
+  output->adaptive = !!adaptive;
+  return output->adaptive;
+}
+
+zfp_stats *set_zfp_output_stats(zfp_output *output, uint enable)
+{
+  if (!enable) {
+    free(output->stats);
+    output->stats = NULL;
+  } else if (!output->stats) {
+    output->stats = (zfp_stats*)malloc(sizeof(zfp_stats));
+    reset_zfp_stats(output->stats);
+  }
+  return output->stats;
+}
+
+void reset_zfp_stats(zfp_stats *stats)
+{
+  stats->count = 0;
+  stats->max_error = 0;
+  stats->sum_error2 = 0;
+  stats->min = INFINITY;
+  stats->max = -INFINITY;
+  stats->rmse = 0;
+  stats->psnr = INFINITY;
+}
+
+void finish_zfp_stats(zfp_stats *stats)
+{
+  if (!stats->count)
+    return;
+  stats->rmse = sqrt(stats->sum_error2 / stats->count);
+  //* Peak signal as in the zfp tools: half the range of the values.
+  stats->psnr = stats->rmse > 0 ?
+                20 * log10((stats->max - stats->min) / (2 * stats->rmse)) :
+                INFINITY;
+}
+
+zfp_index *set_zfp_output_index(zfp_output *output, const zfp_input *input,
+                                size_t granularity)
+{
+  zfp_index *index = output->index;
+  if (!index)
+    index = (zfp_index*)malloc(sizeof(zfp_index));
+  else
+    free(index->offsets);
+  index->granularity = MAX(granularity, (size_t)1);
+  index->count = (get_input_num_blocks(input) + index->granularity - 1) /
+                 index->granularity;
+  index->offsets = (uint64*)calloc(MAX(index->count, (size_t)1),
+                                   sizeof(uint64));
+  output->index = index;
+  return index;
+}
+
 /**
  * @brief Allocate a new zfp_input structure.
 */
@@ -43,10 +143,14 @@ zfp_output *alloc_zfp_output(void)
   zfp_output* output = (zfp_output*)malloc(sizeof(zfp_output));
   if (output) {
     output->data = NULL;
+    output->index = NULL;
+    output->stats = NULL;
     output->minbits = ZFP_MIN_BITS;
     output->maxbits = ZFP_MAX_BITS;
     output->maxprec = ZFP_MAX_PREC;
     output->minexp = ZFP_MIN_EXP;
+    output->readprec = ZFP_MAX_PREC;
+    output->adaptive = 0;
   }
   return output;
 }
@@ -69,6 +173,11 @@ void free_zfp_output(zfp_output* output)
   if (output->data) {
     free(output->data);
   }
+  if (output->index) {
+    free(output->index->offsets);
+    free(output->index);
+  }
+  free(output->stats);
   if (output) {
     free(output);
   }
@@ -88,9 +197,11 @@ zfp_input *init_zfp_input(void* data, data_type dtype, uint dim, ...)
   if (input) {
     input->data = data;
     input->dtype = dtype;
-    //* At least 2D.
+    //* At least 1D.
     input->nx = va_arg(shapes, uint);
-    input->ny = va_arg(shapes, uint);
+    if (dim > 1) {
+      input->ny = va_arg(shapes, uint);
+    }
     if (dim > 2) {
       input->nz = va_arg(shapes, uint);
       if (dim > 3) {
@@ -121,7 +232,10 @@ uint is_reversible(const zfp_output* output)
 
 uint get_input_dimension(const zfp_input* input)
 {
-  return (input->nx && input->ny)? (input->nz ? (input->nw ? 4 : 3) : 2) : 0;
+  //* A 1D input only sets nx (ny == 0).
+  if (!input->nx)
+    return 0;
+  return input->ny ? (input->nz ? (input->nw ? 4 : 3) : 2) : 1;
 }
 
 size_t get_input_num_blocks(const zfp_input* input)
@@ -131,6 +245,8 @@ size_t get_input_num_blocks(const zfp_input* input)
   size_t bz = (input->nz + 3) / 4;
   size_t bw = (input->nw + 3) / 4;
   switch (get_input_dimension(input)) {
+    case 1:
+      return bx;
     case 2:
       return bx * by;
     case 3:
@@ -184,13 +300,10 @@ uint get_input_precision(const zfp_input* input)
   return (uint)(CHAR_BIT * get_dtype_size(input->dtype));
 }
 
-size_t get_max_output_bytes(const zfp_output *output, const zfp_input *input)
+uint get_max_block_bits(const zfp_output *output, const zfp_input *input)
 {
   int reversible = is_reversible(output);
-  printf("Reversible: %d\n", reversible);
   uint dim = get_input_dimension(input);
-  size_t num_blocks = get_input_num_blocks(input);
-  printf("Total 4^d blocks: %ld\n", num_blocks);
   uint values = (1u << (2 * dim));
   uint maxbits = 0;
 
@@ -219,6 +332,20 @@ size_t get_max_output_bytes(const zfp_output *output, const zfp_input *input)
                                        get_input_precision(input));
   maxbits = MIN(maxbits, output->maxbits);
   maxbits = MAX(maxbits, output->minbits);
+  return maxbits;
+}
+
+size_t get_max_output_bytes(const zfp_output *output, const zfp_input *input)
+{
+  int reversible = is_reversible(output);
+  printf("Reversible: %d\n", reversible);
+  size_t num_blocks = get_input_num_blocks(input);
+  printf("Total 4^d blocks: %ld\n", num_blocks);
+  uint maxbits = get_max_block_bits(output, input);
+
+  if (!maxbits) {
+    return 0;
+  }
   return ((ZFP_HEADER_MAX_BITS + num_blocks * maxbits + SWORD_BITS - 1) & ~
           (SWORD_BITS - 1)) / CHAR_BIT;
 }
@@ -228,6 +355,12 @@ uint get_precision(int maxexp, uint maxprec, int minexp, int dim)
   return MIN(maxprec, (uint)MAX(0, maxexp - minexp + 2 * dim + 2));
 }
 
+uint get_raw_precision(int maxexp, uint maxprec, int minexp)
+{
+  //* Truncation errors stay below 2^(minexp - 1); no transform gain to undo.
+  return MIN(MIN(maxprec, 31u), (uint)MAX(0, maxexp - minexp + 1));
+}
+
 /* True if max compressed size exceeds maxbits */
 int exceeded_maxbits(uint maxbits, uint maxprec, uint size)
 {
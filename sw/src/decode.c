@@ -24,6 +24,19 @@ void bwd_cast_block(const int32 *iblock, float *fblock, uint n, int emax)
   while (--n);
 }
 
+void scatter_1d_block(const float *block, float *raw, ptrdiff_t sx)
+{
+  for (size_t x = 0; x < 4; x++, raw += sx)
+    *raw = *block++;
+}
+
+void scatter_partial_1d_block(const float *block, float *raw, size_t nx,
+                              ptrdiff_t sx)
+{
+  for (size_t x = 0; x < nx; x++, raw += sx)
+    *raw = *block++;
+}
+
 void scatter_2d_block(const float *block, float *raw,
                       ptrdiff_t sx, ptrdiff_t sy)
 {
@@ -41,6 +54,63 @@ void scatter_partial_2d_block(const float *block, float *raw,
       *raw = *block;
 }
 
+void scatter_input_block(const float *block, const zfp_input *input, size_t x,
+                         size_t y, size_t dim)
+{
+  float *data = (float*)input->data;
+  size_t nx = input->nx;
+  ptrdiff_t sx = input->sx ? input->sx : 1;
+
+  if (dim == 1) {
+    float *raw = data + sx * (ptrdiff_t)x;
+    if (nx - x < 4)
+      scatter_partial_1d_block(block, raw, nx - x, sx);
+    else
+      scatter_1d_block(block, raw, sx);
+    return;
+  }
+  size_t ny = input->ny;
+  ptrdiff_t sy = input->sy ? input->sy : (ptrdiff_t)nx;
+  float *raw = data + sx * (ptrdiff_t)x + sy * (ptrdiff_t)y;
+  if (nx - x < 4 || ny - y < 4)
+    scatter_partial_2d_block(block, raw, MIN(nx - x, 4u), MIN(ny - y, 4u), sx,
+                             sy);
+  else
+    scatter_2d_block(block, raw, sx, sy);
+}
+
+void scatter_add_1d_block(const float *block, float *raw, float alpha,
+                          ptrdiff_t sx)
+{
+  for (size_t x = 0; x < 4; x++, raw += sx)
+    *raw += alpha * *block++;
+}
+
+void scatter_add_partial_1d_block(const float *block, float *raw, float alpha,
+                                  size_t nx, ptrdiff_t sx)
+{
+  for (size_t x = 0; x < nx; x++, raw += sx)
+    *raw += alpha * *block++;
+}
+
+void scatter_add_2d_block(const float *block, float *raw, float alpha,
+                          ptrdiff_t sx, ptrdiff_t sy)
+{
+  for (size_t y = 0; y < 4; y++, raw += sy - 4 * sx)
+    for (size_t x = 0; x < 4; x++, raw += sx) {
+      *raw += alpha * *block++;
+    }
+}
+
+void scatter_add_partial_2d_block(const float *block, float *raw, float alpha,
+                                  size_t nx, size_t ny,
+                                  ptrdiff_t sx, ptrdiff_t sy)
+{
+  for (size_t y = 0; y < ny; y++, raw += sy - (ptrdiff_t)nx * sx, block += 4 - nx)
+    for (size_t x = 0; x < nx; x++, raw += sx, block++)
+      *raw += alpha * *block;
+}
+
 int32 negabinary_to_twoscomplement(uint32 x)
 {
   return (int32)((x ^ NBMASK) - NBMASK);
@@ -99,6 +169,11 @@ void bwd_lift_vector(int32 *p, ptrdiff_t s)
   *p = x;
 }
 
+void bwd_decorrelate_1d_block(int32 *iblock)
+{
+  bwd_lift_vector(iblock, 1);
+}
+
 void bwd_decorrelate_2d_block(int32 *iblock)
 {
   uint x, y;
@@ -138,6 +213,48 @@ uint decode_full_bitplanes(stream *s, uint32 *const ublock,
   return (uint)(stream_roffset(s) - offset);
 }
 
+void skip_bitplanes(stream *s, uint planes, uint n, uint block_size)
+{
+  for (; planes; planes--) {
+    if (n == block_size) {
+      //* Every remaining plane is coded verbatim: jump over all of them.
+      stream_skip(s, (uint64)planes * block_size);
+      return;
+    }
+    //* Skip the verbatim bits, then scan the group tests a word at a time.
+    stream_read_bits(s, n);
+    for (; n < block_size && stream_read_bit(s); n++)
+      n += stream_scan_zeros(s, block_size - 1 - n);
+  }
+}
+
+uint decode_truncated_bitplanes(stream *s, uint32 *const ublock,
+                                uint maxprec, uint readprec, uint block_size)
+{
+  size_t offset = stream_roffset(s);
+  uint intprec = (uint)(CHAR_BIT * sizeof(uint32));
+  uint kmin = intprec > maxprec ? intprec - maxprec : 0;
+  uint kread = intprec > readprec ? intprec - readprec : 0;
+  uint i, k, n;
+
+  for (i = 0; i < block_size; i++)
+    ublock[i] = 0;
+
+  /* decode one bit plane at a time from MSB to LSB down to kread */
+  for (k = intprec, n = 0; k > kread && k-- > kmin;) {
+    uint64 x = stream_read_bits(s, n);
+    for (; n < block_size && stream_read_bit(s); x += (uint64)1 << n, n++)
+      for (; n < block_size - 1 && !stream_read_bit(s); n++)
+        ;
+    for (i = 0; x; i++, x >>= 1)
+      ublock[i] += (int32)(x & 1u) << k;
+  }
+  //* Planes below kread are only skipped over to find the next block.
+  skip_bitplanes(s, k > kmin ? k - kmin : 0, n, block_size);
+
+  return (uint)(stream_roffset(s) - offset);
+}
+
 uint decode_partial_bitplanes(stream *const s, uint32 *const ublock,
                               uint maxbits, uint maxprec, uint block_size)
 {
@@ -184,22 +301,45 @@ uint decode_partial_bitplanes(stream *const s, uint32 *const ublock,
 
 uint decode_iblock(stream *const out_data, uint minbits, uint maxbits,
                    uint maxprec, int32 *iblock, size_t dim)
+{
+  uint decoded_bits = decode_coefficients(out_data, minbits, maxbits, maxprec,
+                                          maxprec, iblock, dim);
+  /* perform decorrelating transform */
+  bwd_decorrelate_block(iblock, dim);
+  return decoded_bits;
+}
+
+uint decode_coefficients(stream *const out_data, uint minbits, uint maxbits,
+                         uint maxprec, uint readprec, int32 *iblock, size_t dim)
 {
   size_t block_size = BLOCK_SIZE(dim);
   uint32 ublock[block_size];
-  uint decoded_bits;
+  uint decoded_bits = 0;
 
   /* decode integer mantissa block */
-  if (exceeded_maxbits(maxbits, maxprec, dim)) {
+  if (exceeded_maxbits(maxbits, maxprec, block_size)) {
     if (block_size < BLOCK_SIZE_4D) {
-      decoded_bits = decode_partial_bitplanes(out_data, ublock, maxbits, maxprec,
-                                              dim);
+      //* A fixed-rate block has a known length (minbits == maxbits), so
+      //* decoding stops after readprec planes and the tail is skipped below.
+      uint prec = minbits >= maxbits ? readprec : maxprec;
+      decoded_bits = decode_partial_bitplanes(out_data, ublock, maxbits, prec,
+                                              block_size);
+      //* Drop the planes below readprec.
+      if (readprec < prec) {
+        uint32 mask = readprec ? ~(uint32)0 << (CHAR_BIT * sizeof(uint32) - readprec)
+                      : 0;
+        for (size_t i = 0; i < block_size; i++)
+          ublock[i] &= mask;
+      }
     } else {
       //TODO: Implement 4d decoding.
     }
   } else {
     if (block_size < BLOCK_SIZE_4D) {
-      decoded_bits = decode_full_bitplanes(out_data, ublock, maxprec, dim);
+      decoded_bits = readprec < maxprec ?
+                     decode_truncated_bitplanes(out_data, ublock, maxprec, readprec,
+                                                block_size) :
+                     decode_full_bitplanes(out_data, ublock, maxprec, block_size);
     } else {
       //TODO: Implement 4d decoding.
     }
@@ -211,14 +351,64 @@ uint decode_iblock(stream *const out_data, uint minbits, uint maxbits,
     decoded_bits = minbits;
   }
   /* reorder unsigned coefficients and convert to signed integer */
-  bwd_reorder_uint2int(ublock, iblock, PERM_2D, block_size);
-  /* perform decorrelating transform */
-  bwd_decorrelate_2d_block(iblock);
+  bwd_reorder_uint2int(ublock, iblock, BLOCK_PERM(dim), block_size);
   return decoded_bits;
 }
 
+void bwd_decorrelate_block(int32 *iblock, size_t dim)
+{
+  switch (dim) {
+    case 1:
+      bwd_decorrelate_1d_block(iblock);
+      break;
+    case 2:
+      bwd_decorrelate_2d_block(iblock);
+      break;
+    //TODO: Implement other dimensions.
+    default:
+      break;
+  }
+}
+
+void bwd_transform_iblock(const uint32 *ublock, int32 *iblock, size_t dim)
+{
+  bwd_reorder_uint2int(ublock, iblock, BLOCK_PERM(dim), BLOCK_SIZE(dim));
+  bwd_decorrelate_block(iblock, dim);
+}
+
+uint decode_coefficient_block(zfp_output *output, int32 *iblock, int *emax,
+                              uint readprec, size_t dim)
+{
+  uint bits = 1;
+  size_t block_size = BLOCK_SIZE(dim);
+  if (stream_read_bit(output->data)) {
+    bits += EBITS;
+    *emax = (int)stream_read_bits(output->data, EBITS) - EBIAS;
+    uint maxprec = get_precision(*emax, output->maxprec, output->minexp, dim);
+    bits += decode_coefficients(
+              output->data,
+              output->minbits - MIN(bits, output->minbits),
+              output->maxbits - bits,
+              maxprec,
+              MIN(readprec, maxprec),
+              iblock,
+              dim);
+  } else {
+    *emax = -EBIAS;
+    for (size_t i = 0; i < block_size; i++)
+      iblock[i] = 0;
+    if (output->minbits > bits) {
+      stream_skip(output->data, output->minbits - bits);
+      bits = output->minbits;
+    }
+  }
+  return bits;
+}
+
 uint decode_fblock(zfp_output* output, float* fblock, size_t dim)
 {
+  if (output->adaptive)
+    return decode_adaptive_fblock(output, fblock, dim);
   uint bits = 1;
   size_t block_size = BLOCK_SIZE(dim);
   int32 iblock[block_size];
@@ -230,14 +420,16 @@ uint decode_fblock(zfp_output* output, float* fblock, size_t dim)
     bits += EBITS;
     emax = (int)stream_read_bits(output->data, EBITS) - EBIAS;
     maxprec = get_precision(emax, output->maxprec, output->minexp, dim);
-    /* decode integer block */
-    bits += decode_iblock(
+    /* decode integer block (up to readprec bit planes) */
+    bits += decode_coefficients(
               output->data,
               output->minbits - MIN(bits, output->minbits),
               output->maxbits - bits,
               maxprec,
+              MIN(output->readprec, maxprec),
               iblock,
               dim);
+    bwd_decorrelate_block(iblock, dim);
     /* perform inverse block-floating-point transform */
     bwd_cast_block(iblock, fblock, block_size, emax);
   } else {
@@ -251,4 +443,106 @@ uint decode_fblock(zfp_output* output, float* fblock, size_t dim)
     }
   }
   return bits;
-}
\ No newline at end of file
+}
+
+uint skip_fblock(zfp_output *output, size_t dim)
+{
+  if (output->adaptive) {
+    float fblock[BLOCK_SIZE(dim)];
+    return decode_adaptive_fblock(output, fblock, dim);
+  }
+  int32 iblock[BLOCK_SIZE(dim)];
+  int emax;
+  //* No bit plane is read: the coefficients are skipped over.
+  return decode_coefficient_block(output, iblock, &emax, 0, dim);
+}
+
+uint decode_fblock_bitplanes(zfp_output *output, float *fblock,
+                             uint biased_emax, size_t dim)
+{
+  uint bits = 1;
+  uint block_size = BLOCK_SIZE(dim);
+  if (biased_emax) {
+    int emax = (int)biased_emax - EBIAS;
+    uint maxprec = get_precision(emax, output->maxprec, output->minexp, dim);
+    int32 iblock[block_size];
+    bits += EBITS;
+    bits += decode_coefficients(
+              output->data,
+              output->minbits - MIN(bits, output->minbits),
+              output->maxbits - bits,
+              maxprec,
+              MIN(output->readprec, maxprec),
+              iblock,
+              dim);
+    bwd_decorrelate_block(iblock, dim);
+    bwd_cast_block(iblock, fblock, block_size, emax);
+  } else {
+    for (uint i = 0; i < block_size; i++)
+      fblock[i] = 0;
+    if (output->minbits > bits) {
+      stream_skip(output->data, output->minbits - bits);
+      bits = output->minbits;
+    }
+  }
+  return bits;
+}
+
+uint decode_adaptive_fblock(zfp_output *output, float *fblock, size_t dim)
+{
+  uint bits = 1;
+  uint i, block_size = BLOCK_SIZE(dim);
+
+  if (!stream_read_bit(output->data)) {
+    for (i = 0; i < block_size; i++)
+      fblock[i] = 0;
+    if (output->minbits > bits) {
+      stream_skip(output->data, output->minbits - bits);
+      bits = output->minbits;
+    }
+    return bits;
+  }
+
+  block_mode mode = block_transform;
+  bits++;
+  if (stream_read_bit(output->data)) {
+    bits++;
+    mode = stream_read_bit(output->data) ? block_constant : block_raw;
+  }
+  bits += EBITS;
+  int emax = (int)stream_read_bits(output->data, EBITS) - EBIAS;
+  int32 iblock[block_size];
+
+  if (mode == block_transform) {
+    uint maxprec = get_precision(emax, output->maxprec, output->minexp, dim);
+    bits += decode_coefficients(
+              output->data,
+              output->minbits - MIN(bits, output->minbits),
+              output->maxbits - bits,
+              maxprec,
+              MIN(output->readprec, maxprec),
+              iblock,
+              dim);
+    bwd_decorrelate_block(iblock, dim);
+  } else {
+    uint rawprec = get_raw_precision(emax, output->maxprec, output->minexp);
+    uint shift = 31 - rawprec;
+    int32 half = shift ? (int32)1 << (shift - 1) : 0;
+    uint n = mode == block_raw ? block_size : 1;
+    for (i = 0; i < n; i++) {
+      //* Sign-extend the rawprec-bit integer, scale it back by 2^shift and
+      //* reconstruct at the midpoint.
+      uint32 q = (uint32)stream_read_bits(output->data, rawprec);
+      iblock[i] = ((int32)(q << (32 - rawprec)) >> 1) + half;
+    }
+    for (; i < block_size; i++)
+      iblock[i] = iblock[0];
+    bits += n * rawprec;
+    if (output->minbits > bits) {
+      stream_skip(output->data, output->minbits - bits);
+      bits = output->minbits;
+    }
+  }
+  bwd_cast_block(iblock, fblock, block_size, emax);
+  return bits;
+}
@@ -0,0 +1,166 @@
+// Description: Temporal delta coding of tensor sequences with keyframes.
+// Documentation: ./include/delta.h
+
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "delta.h"
+#include "decode.h"
+#include "encode.h"
+#include "stream.h"
+
+
+zfp_delta *alloc_zfp_delta(const zfp_input *input, uint keyframe_interval)
+{
+  zfp_delta *state = (zfp_delta*)malloc(sizeof(zfp_delta));
+  if (state) {
+    size_t n = input->nx * MAX(input->ny, (size_t)1);
+    state->nx = input->nx;
+    state->ny = input->ny;
+    state->reference = (float*)calloc(n, sizeof(float));
+    state->keyframe_interval = keyframe_interval;
+    state->frame = 0;
+  }
+  return state;
+}
+
+void free_zfp_delta(zfp_delta *state)
+{
+  if (!state)
+    return;
+  free(state->reference);
+  free(state);
+}
+
+void reset_zfp_delta(zfp_delta *state)
+{
+  state->frame = 0;
+}
+
+/* Gather an mx*my (partial) block of a 1D or 2D tensor */
+static void gather_frame_block(float *fblock, const float *raw, size_t mx,
+                               size_t my, ptrdiff_t sx, ptrdiff_t sy,
+                               size_t dim)
+{
+  if (dim == 1) {
+    if (mx < 4)
+      gather_partial_1d_block(fblock, raw, mx, sx);
+    else
+      gather_1d_block(fblock, raw, sx);
+  } else {
+    if (mx < 4 || my < 4)
+      gather_partial_2d_block(fblock, raw, mx, my, sx, sy);
+    else
+      gather_2d_block(fblock, raw, sx, sy);
+  }
+}
+
+/* Scatter an mx*my (partial) block of a 1D or 2D tensor */
+static void scatter_frame_block(const float *fblock, float *raw, size_t mx,
+                                size_t my, ptrdiff_t sx, ptrdiff_t sy,
+                                size_t dim)
+{
+  if (dim == 1) {
+    if (mx < 4)
+      scatter_partial_1d_block(fblock, raw, mx, sx);
+    else
+      scatter_1d_block(fblock, raw, sx);
+  } else {
+    if (mx < 4 || my < 4)
+      scatter_partial_2d_block(fblock, raw, mx, my, sx, sy);
+    else
+      scatter_2d_block(fblock, raw, sx, sy);
+  }
+}
+
+/**
+ * @brief Code the blocks of one frame and update the reference.
+ * @param encode Encode the input (nonzero) or decode into it (zero).
+ * @param key Code the tensor itself (nonzero) or its residual (zero).
+*/
+static void code_frame(zfp_output *output, const zfp_input *input,
+                       zfp_delta *state, int encode, int key)
+{
+  size_t dim = get_input_dimension(input);
+  size_t block_size = BLOCK_SIZE(dim);
+  float *data = (float*)input->data;
+  size_t nx = state->nx;
+  size_t ny = MAX(state->ny, (size_t)1);
+  ptrdiff_t sx = input->sx ? input->sx : 1;
+  ptrdiff_t sy = input->sy ? input->sy : (ptrdiff_t)nx;
+
+  for (size_t y = 0; y < ny; y += 4)
+    for (size_t x = 0; x < nx; x += 4) {
+      size_t mx = MIN(nx - x, (size_t)4);
+      size_t my = MIN(ny - y, (size_t)4);
+      float *raw = data + sx * (ptrdiff_t)x + sy * (ptrdiff_t)y;
+      float *ref = state->reference + x + nx * y;
+      float fblock[block_size];
+      float rblock[block_size];
+      uint i;
+
+      if (!key)
+        gather_frame_block(rblock, ref, mx, my, 1, (ptrdiff_t)nx, dim);
+      if (encode) {
+        gather_frame_block(fblock, raw, mx, my, sx, sy, dim);
+        if (!key)
+          for (i = 0; i < block_size; i++)
+            fblock[i] -= rblock[i];
+        //* The reference follows the decoder, so errors do not accumulate.
+        encode_reconstruct_fblock(output, fblock, dim);
+      } else {
+        decode_fblock(output, fblock, dim);
+      }
+      if (!key)
+        for (i = 0; i < block_size; i++)
+          fblock[i] += rblock[i];
+      scatter_frame_block(fblock, ref, mx, my, 1, (ptrdiff_t)nx, dim);
+      if (!encode)
+        scatter_frame_block(fblock, raw, mx, my, sx, sy, dim);
+    }
+}
+
+/* Move to the next frame, wrapping around at the keyframe interval */
+static void next_frame(zfp_delta *state)
+{
+  state->frame++;
+  if (state->keyframe_interval && state->frame >= state->keyframe_interval)
+    state->frame = 0;
+}
+
+size_t zfp_compress_delta(zfp_output *output, const zfp_input *input,
+                          zfp_delta *state)
+{
+  size_t dim = get_input_dimension(input);
+  if (dim < 1 || dim > 2)
+    //TODO: Implement other dimensions.
+    return 0;
+
+  int key = !state->frame;
+  stream_write_bit(output->data, key);
+  code_frame(output, input, state, 1, key);
+  next_frame(state);
+
+  stream_flush(output->data);
+  return stream_size_bytes(output->data);
+}
+
+size_t zfp_decompress_delta(zfp_output *output, const zfp_input *input,
+                            zfp_delta *state)
+{
+  size_t dim = get_input_dimension(input);
+  if (dim < 1 || dim > 2)
+    //TODO: Implement other dimensions.
+    return 0;
+
+  //* The keyframe bit resynchronizes the decoder with the encoder.
+  int key = (int)stream_read_bit(output->data);
+  if (key)
+    state->frame = 0;
+  code_frame(output, input, state, 0, key);
+  next_frame(state);
+
+  stream_algin_next_word(output->data);
+  return stream_size_bytes(output->data);
+}
@@ -4,8 +4,12 @@
 #include <stddef.h>
 #include <stdio.h>
 #include <math.h>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
 
 #include "encode.h"
+#include "decode.h"
 #include "stream.h"
 #include "types.h"
 
@@ -59,6 +63,21 @@ void pad_partial_block(float* block, size_t n, ptrdiff_t s)
   }
 }
 
+void gather_1d_block(float *block, const float *raw, ptrdiff_t sx)
+{
+  for (size_t x = 0; x < 4; x++, raw += sx)
+    *block++ = *raw;
+}
+
+void gather_partial_1d_block(float *block, const float *raw, size_t nx,
+                             ptrdiff_t sx)
+{
+  size_t x;
+  for (x = 0; x < nx; x++, raw += sx)
+    block[x] = *raw;
+  pad_partial_block(block, nx, 1);
+}
+
 void gather_2d_block(float *block, const float *raw,
                      ptrdiff_t sx, ptrdiff_t sy)
 {
@@ -87,6 +106,31 @@ void gather_partial_2d_block(float *block, const float *raw,
     pad_partial_block(block + x, by, 4);
 }
 
+void gather_input_block(float *block, const zfp_input *input, size_t x,
+                        size_t y, size_t dim)
+{
+  const float *data = (const float*)input->data;
+  size_t nx = input->nx;
+  ptrdiff_t sx = input->sx ? input->sx : 1;
+
+  if (dim == 1) {
+    const float *raw = data + sx * (ptrdiff_t)x;
+    if (nx - x < 4)
+      gather_partial_1d_block(block, raw, nx - x, sx);
+    else
+      gather_1d_block(block, raw, sx);
+    return;
+  }
+  size_t ny = input->ny;
+  ptrdiff_t sy = input->sy ? input->sy : (ptrdiff_t)nx;
+  const float *raw = data + sx * (ptrdiff_t)x + sy * (ptrdiff_t)y;
+  if (nx - x < 4 || ny - y < 4)
+    gather_partial_2d_block(block, raw, MIN(nx - x, 4u), MIN(ny - y, 4u), sx,
+                            sy);
+  else
+    gather_2d_block(block, raw, sx, sy);
+}
+
 void gather_4d_block(float *block, const float *raw,
                      ptrdiff_t sx, ptrdiff_t sy, ptrdiff_t sz, ptrdiff_t sw)
 {
@@ -248,6 +292,11 @@ void fwd_lift_vector(int32 *p, ptrdiff_t s)
   */
 }
 
+void fwd_decorrelate_1d_block(int32 *iblock)
+{
+  fwd_lift_vector(iblock, 1);
+}
+
 void fwd_decorrelate_2d_block(int32 *iblock)
 {
   uint x, y;
@@ -259,6 +308,21 @@ void fwd_decorrelate_2d_block(int32 *iblock)
     fwd_lift_vector(iblock + 1 * x, 4);
 }
 
+void fwd_decorrelate_block(int32 *iblock, size_t dim)
+{
+  switch (dim) {
+    case 1:
+      fwd_decorrelate_1d_block(iblock);
+      break;
+    case 2:
+      fwd_decorrelate_2d_block(iblock);
+      break;
+    //TODO: Implement other dimensions.
+    default:
+      break;
+  }
+}
+
 /* Map two's complement signed integer to negabinary unsigned integer */
 uint32 twoscomplement_to_negabinary(int32 x)
 {
@@ -271,7 +335,7 @@ void fwd_reorder_int2uint(uint32* ublock, const int32* iblock,
 {
   do
     *ublock++ = twoscomplement_to_negabinary(iblock[*perm++]);
-  while (n--);
+  while (--n);
 }
 
 /* Compress <= 64 (1-3D) unsigned integers with rate contraint */
@@ -408,25 +472,216 @@ uint encode_all_bitplanes(stream *const s, const uint32 *const ublock,
 }
 
 
-//! The `const` pointers should be `restrict` pointers in C, using `const` for now.
-uint encode_iblock(stream *const out_data, uint minbits, uint maxbits,
-                   uint maxprec, int32 *iblock, size_t dim)
+/* encode_all_bitplanes() for a compile-time block size of at most 16 */
+static inline uint encode_planes_in_register(stream *const s,
+                                             const uint32 *const ublock,
+                                             uint maxprec,
+                                             const uint block_size)
 {
-  size_t block_size = BLOCK_SIZE(dim);
-  uint32 ublock[block_size];
+  uint intprec = (uint)(CHAR_BIT * sizeof(uint32));
+  uint kmin = intprec > maxprec ? intprec - maxprec : 0;
+  uint k, n;
+  uint bits = 0;
+#ifdef __SSE2__
+  __m128i v0, v1, v2, v3;
+  if (block_size == BLOCK_SIZE_2D) {
+    v0 = _mm_loadu_si128((const __m128i*)ublock);
+    v1 = _mm_loadu_si128((const __m128i*)(ublock + 4));
+    v2 = _mm_loadu_si128((const __m128i*)(ublock + 8));
+    v3 = _mm_loadu_si128((const __m128i*)(ublock + 12));
+  }
+#endif
 
-  //* Perform forward decorrelation transform.
-  switch (dim) {
-    case 2:
-      fwd_decorrelate_2d_block(iblock);
-      break;
-    //TODO: Implement other dimensions.
+  for (k = intprec, n = 0; k-- > kmin;) {
+    uint64 x = 0;
+#ifdef __SSE2__
+    if (block_size == BLOCK_SIZE_2D) {
+      //* The sign bits hold bit plane #k; shift the next plane up.
+      x = (uint64)(_mm_movemask_ps(_mm_castsi128_ps(v0)) |
+                   _mm_movemask_ps(_mm_castsi128_ps(v1)) << 4 |
+                   _mm_movemask_ps(_mm_castsi128_ps(v2)) << 8 |
+                   _mm_movemask_ps(_mm_castsi128_ps(v3)) << 12);
+      v0 = _mm_add_epi32(v0, v0);
+      v1 = _mm_add_epi32(v1, v1);
+      v2 = _mm_add_epi32(v2, v2);
+      v3 = _mm_add_epi32(v3, v3);
+    } else
+#endif
+      for (uint i = 0; i < block_size; i++)
+        x += (uint64)((ublock[i] >> k) & 1u) << i;
+
+    //* Assemble the code of the whole plane, then write it at once.
+    //* At most 2 * block_size + 1 bits, as n <= block_size <= 16.
+    uint64 code = x & (((uint64)1 << n) - 1);
+    uint len = n;
+    x = n < block_size ? x >> n : 0;
+    while (n < block_size) {
+      if (!x) {
+        //* Negative group test.
+        len++;
+        break;
+      }
+      uint t = (uint)__builtin_ctzll(x);
+      if (n + t + 1 < block_size) {
+        //* Positive group test, t zeros and the one-bit.
+        code += ((uint64)1 | (uint64)2 << t) << len;
+        len += t + 2;
+        x >>= t + 1;
+        n += t + 1;
+      } else {
+        //* The last one-bit of the block is implied.
+        code += (uint64)1 << len;
+        len += t + 1;
+        n = block_size;
+      }
+    }
+    stream_write_bits(s, code, len);
+    bits += len;
+  }
+  return bits;
+}
+
+uint encode_precision_bitplanes(stream *const s, const uint32 *const ublock,
+                                uint maxprec, uint block_size)
+{
+  //* Constant block sizes let the compiler unroll the plane transposition.
+  switch (block_size) {
+    case BLOCK_SIZE(1):
+      return encode_planes_in_register(s, ublock, maxprec, BLOCK_SIZE(1));
+    case BLOCK_SIZE_2D:
+      return encode_planes_in_register(s, ublock, maxprec, BLOCK_SIZE_2D);
     default:
+      return encode_all_bitplanes(s, ublock, maxprec, block_size);
+  }
+}
+
+/* Count the bits of one bit plane #k coded by encode_all_bitplanes() */
+static uint count_bitplane(uint64 x, uint *n, uint block_size)
+{
+  //* The first n bits are verbatim.
+  uint bits = *n;
+  x = *n < block_size ? x >> *n : 0;
+  while (*n < block_size) {
+    //* Group test.
+    bits++;
+    if (!x)
       break;
+    //* Scan over t zeros up to the next one-bit (implicit at the last value).
+    uint t = (uint)__builtin_ctzll(x);
+    bits += MIN(t + 1, block_size - 1 - *n);
+    *n += t + 1;
+    x >>= t;
+    x >>= 1;
+  }
+  return bits;
+}
+
+uint truncate_bitplanes(uint32 *const ublock, uint maxbits, uint maxprec,
+                        uint block_size)
+{
+  uint intprec = (uint)(CHAR_BIT * sizeof(uint32));
+  uint kmin = intprec > maxprec ? intprec - maxprec : 0;
+  uint bits = 0;
+  uint i, k, n;
+
+  if (!exceeded_maxbits(maxbits, maxprec, block_size)) {
+    //* All planes down to kmin are coded verbatim or by group tests, so the
+    //* decoder recovers exactly those planes.
+    uint32 mask = kmin < intprec ? ~(uint32)0 << kmin : 0;
+    for (k = intprec, n = 0; k-- > kmin;) {
+      uint64 x = 0;
+      for (i = 0; i < block_size; i++)
+        x += (uint64)((ublock[i] >> k) & 1u) << i;
+      bits += count_bitplane(x, &n, block_size);
+    }
+    for (i = 0; i < block_size; i++)
+      ublock[i] &= mask;
+    return bits;
   }
-  //* Reorder signed coefficients and convert to unsigned integer
-  fwd_reorder_int2uint(ublock, iblock, PERM_2D, block_size);
 
+  //* Mirror encode_partial_bitplanes() and keep the bits that
+  //* decode_partial_bitplanes() would deposit.
+  uint32 planes[ZFP_MAX_PREC];
+  uint coded = 0;
+  bits = maxbits;
+  for (k = intprec, n = 0; bits && k-- > kmin; coded++) {
+    uint64 x = 0;
+    for (i = 0; i < block_size; i++)
+      x += (uint64)((ublock[i] >> k) & 1u) << i;
+    uint m = MIN(n, bits);
+    bits -= m;
+    uint64 r = m ? x & (((uint64)2 << (m - 1)) - 1) : 0;
+    x >>= m;
+    for (; bits && n < block_size; x >>= 1, n++) {
+      bits--;
+      if (!x)
+        break;
+      for (; bits && n < block_size - 1; x >>= 1, n++) {
+        bits--;
+        if (x & 1u)
+          break;
+      }
+      //* The decoder sets the bit where the scan stopped.
+      r += (uint64)1 << n;
+    }
+    planes[coded] = (uint32)r;
+  }
+  for (i = 0; i < block_size; i++) {
+    uint32 u = 0;
+    for (k = 0; k < coded; k++)
+      u += ((planes[k] >> i) & 1u) << (intprec - 1 - k);
+    ublock[i] = u;
+  }
+  return maxbits - bits;
+}
+
+void get_bitplane_profile(uint *bits, const uint32 *const ublock,
+                          uint block_size)
+{
+  uint intprec = (uint)(CHAR_BIT * sizeof(uint32));
+  uint k, n;
+
+  bits[0] = 0;
+  for (k = intprec, n = 0; k-- > 0;) {
+    uint64 x = 0;
+    for (uint i = 0; i < block_size; i++)
+      x += (uint64)((ublock[i] >> k) & 1u) << i;
+    bits[intprec - k] = bits[intprec - 1 - k] +
+                        count_bitplane(x, &n, block_size);
+  }
+}
+
+uint reconstruct_iblock(int32 *iblock, uint maxbits, uint maxprec, size_t dim)
+{
+  size_t block_size = BLOCK_SIZE(dim);
+  uint32 ublock[block_size];
+
+  fwd_reorder_int2uint(ublock, iblock, BLOCK_PERM(dim), block_size);
+  uint bits = truncate_bitplanes(ublock, maxbits, maxprec, block_size);
+  bwd_transform_iblock(ublock, iblock, dim);
+  return bits;
+}
+
+/* reconstruct_iblock() without counting bits, for blocks coded already */
+static void truncate_ublock(uint32 *ublock, uint maxbits, uint maxprec,
+                            uint block_size)
+{
+  if (exceeded_maxbits(maxbits, maxprec, block_size)) {
+    truncate_bitplanes(ublock, maxbits, maxprec, block_size);
+    return;
+  }
+  //* Without a bit budget the decoder gets every plane down to kmin.
+  uint intprec = (uint)(CHAR_BIT * sizeof(uint32));
+  uint kmin = intprec > maxprec ? intprec - maxprec : 0;
+  uint32 mask = kmin < intprec ? ~(uint32)0 << kmin : 0;
+  for (uint i = 0; i < block_size; i++)
+    ublock[i] &= mask;
+}
+
+/* Code reordered coefficients and pad them to minbits */
+static uint encode_ublock(stream *const out_data, uint minbits, uint maxbits,
+                          uint maxprec, const uint32 *ublock, uint block_size)
+{
   uint encoded_bits = 0;
   //* Bitplane coding with the fastest implementation.
   if (exceeded_maxbits(maxbits, maxprec, block_size)) {
@@ -440,7 +695,8 @@ uint encode_iblock(stream *const out_data, uint minbits, uint maxbits,
   } else {
     if (block_size < BLOCK_SIZE_4D) {
       //* Encode all bitplanes without rate constraint.
-      encoded_bits = encode_all_bitplanes(out_data, ublock, maxprec, block_size);
+      encoded_bits = encode_precision_bitplanes(out_data, ublock, maxprec,
+                                                block_size);
     } else {
       //TODO: Implement 4d encoding
     }
@@ -454,42 +710,230 @@ uint encode_iblock(stream *const out_data, uint minbits, uint maxbits,
   return encoded_bits;
 }
 
-uint encode_fblock(zfp_output* output, const float *fblock, size_t dim)
+/**
+ * @brief Code a block after its exponent, the path every block encoder
+ *  shares.
+ * @param s Stream to write to, NULL to only count the bits.
+ * @param fblock Block to cast and decorrelate into coeffs, NULL if coeffs
+ *  already holds the decorrelated coefficients.
+ * @param emax Common exponent of the block.
+ * @param mode_bits Header bits between the one-bit and the exponent (0 for
+ *  the regular layout, 1 for the transform mode of adaptive streams).
+ * @param header Nonzero to write the header, zero if the caller codes it
+ *  elsewhere (it is counted either way).
+ * @param recon Block to write the decoder's reconstruction to, or NULL.
+ * @return Number of bits of the block, padding included.
+*/
+static uint encode_fblock_common(const zfp_output *output, stream *s,
+                                 const float *fblock, int32 *coeffs, int emax,
+                                 uint mode_bits, uint header, float *recon,
+                                 size_t dim)
 {
   uint bits = 1;
   uint block_size = BLOCK_SIZE(dim);
-  //* Compute maximum exponent.
-  int emax = get_block_exponent(fblock, block_size);
   uint maxprec = get_precision(emax, output->maxprec, output->minexp, dim);
   //* IEEE 754 exponent bias.
   uint biased_emax = maxprec ? (uint)(emax + EBIAS) : 0;
 
-  /* encode block only if biased exponent is nonzero */
-  if (biased_emax) {
-    int32 iblock[block_size];
-    /* encode common exponent (emax); LSB indicates that exponent is nonzero */
-    bits += EBITS;
-    stream_write_bits(output->data, 2 * biased_emax + 1, bits);
+  if (!biased_emax) {
+    //* Compress a block of all zeros and add padding if it's fixed-rate.
+    if (s && header)
+      stream_write_bit(s, 0);
+    if (s && output->minbits > bits)
+      stream_pad(s, output->minbits - bits);
+    if (recon)
+      for (uint i = 0; i < block_size; i++)
+        recon[i] = 0;
+    return MAX(bits, output->minbits);
+  }
+
+  /* encode common exponent (emax); LSB indicates that exponent is nonzero */
+  bits += mode_bits + EBITS;
+  if (s && header)
+    stream_write_bits(s, 1 + ((uint64)biased_emax << (1 + mode_bits)), bits);
+  if (fblock) {
     /* perform forward block-floating-point transform */
-    fwd_cast_block(iblock, fblock, block_size, emax);
-    /* encode integer block */
-    bits += encode_iblock(
-              output->data,
-              //* Deduct the exponent bits, which are already encoded.
-              output->minbits - MIN(bits, output->minbits),
-              output->maxbits - bits,
-              maxprec,
-              iblock,
-              dim);
+    fwd_cast_block(coeffs, fblock, block_size, emax);
+    fwd_decorrelate_block(coeffs, dim);
+  }
+  uint32 ublock[block_size];
+  fwd_reorder_int2uint(ublock, coeffs, BLOCK_PERM(dim), block_size);
+  uint maxbits = output->maxbits - bits;
+  if (s) {
+    //* Deduct the exponent bits, which are already encoded.
+    bits += encode_ublock(s, output->minbits - MIN(bits, output->minbits),
+                          maxbits, maxprec, ublock, block_size);
+    //* The decoder recovers the coefficients the bit budget kept.
+    if (recon)
+      truncate_ublock(ublock, maxbits, maxprec, block_size);
   } else {
-    /* write single zero-bit to indicate that all values are zero */
-    //* Compress a block of all zeros and add padding if it's fixed-rate.
-    stream_write_bit(output->data, 0);
-    if (output->minbits > bits) {
-      stream_pad(output->data, output->minbits - bits);
-      bits = output->minbits;
+    bits += truncate_bitplanes(ublock, maxbits, maxprec, block_size);
+  }
+  if (recon) {
+    bwd_transform_iblock(ublock, coeffs, dim);
+    bwd_cast_block(coeffs, recon, block_size, emax);
+  }
+  //* Account for the padding of fixed-rate blocks.
+  return MAX(bits, output->minbits);
+}
+
+uint roundtrip_fblock(const zfp_output *output, float *fblock, size_t dim)
+{
+  int32 iblock[BLOCK_SIZE(dim)];
+  int emax = get_block_exponent(fblock, BLOCK_SIZE(dim));
+  return encode_fblock_common(output, NULL, fblock, iblock, emax, 0, 0,
+                              fblock, dim);
+}
+
+//! The `const` pointers should be `restrict` pointers in C, using `const` for now.
+uint encode_iblock(stream *const out_data, uint minbits, uint maxbits,
+                   uint maxprec, int32 *iblock, size_t dim)
+{
+  //* Perform forward decorrelation transform.
+  fwd_decorrelate_block(iblock, dim);
+  return encode_coefficients(out_data, minbits, maxbits, maxprec, iblock, dim);
+}
+
+uint encode_coefficients(stream *const out_data, uint minbits, uint maxbits,
+                         uint maxprec, const int32 *iblock, size_t dim)
+{
+  uint block_size = BLOCK_SIZE(dim);
+  uint32 ublock[block_size];
+
+  //* Reorder signed coefficients and convert to unsigned integer
+  fwd_reorder_int2uint(ublock, iblock, BLOCK_PERM(dim), block_size);
+  return encode_ublock(out_data, minbits, maxbits, maxprec, ublock,
+                       block_size);
+}
+
+uint encode_coefficient_block(zfp_output *output, const int32 *iblock,
+                              int emax, size_t dim)
+{
+  uint block_size = BLOCK_SIZE(dim);
+  int32 coeffs[block_size];
+  for (uint i = 0; i < block_size; i++)
+    coeffs[i] = iblock[i];
+  return encode_fblock_common(output, output->data, NULL, coeffs, emax, 0, 1,
+                              NULL, dim);
+}
+
+uint encode_fblock(zfp_output* output, const float *fblock, size_t dim)
+{
+  if (output->adaptive)
+    return encode_adaptive_fblock(output, fblock, NULL, dim);
+  int32 iblock[BLOCK_SIZE(dim)];
+  //* Compute maximum exponent.
+  int emax = get_block_exponent(fblock, BLOCK_SIZE(dim));
+  return encode_fblock_common(output, output->data, fblock, iblock, emax, 0, 1,
+                              NULL, dim);
+}
+
+uint encode_reconstruct_fblock(zfp_output *output, float *fblock, size_t dim)
+{
+  if (output->adaptive)
+    return encode_adaptive_fblock(output, fblock, fblock, dim);
+  int32 iblock[BLOCK_SIZE(dim)];
+  int emax = get_block_exponent(fblock, BLOCK_SIZE(dim));
+  return encode_fblock_common(output, output->data, fblock, iblock, emax, 0, 1,
+                              fblock, dim);
+}
+
+uint encode_fblock_bitplanes(zfp_output *output, const float *fblock,
+                             uint biased_emax, size_t dim)
+{
+  //* Count the header as the regular layout does, to keep its bit budget.
+  int32 iblock[BLOCK_SIZE(dim)];
+  return encode_fblock_common(output, output->data, fblock, iblock,
+                              (int)biased_emax - EBIAS, 0, 0, NULL, dim);
+}
+
+/* Estimate the embedded code length of reordered coefficients */
+static uint estimate_bitplane_bits(const uint32 *ublock, uint maxprec,
+                                   uint block_size)
+{
+  uint intprec = (uint)(CHAR_BIT * sizeof(uint32));
+  uint kmin = intprec > maxprec ? intprec - maxprec : 0;
+  uint bits = 0;
+  //* Each value costs its planes from the first one-bit down to kmin,
+  //* plus about one group test or scan bit to find that first one-bit.
+  for (uint i = 0; i < block_size; i++) {
+    uint32 u = ublock[i] >> kmin;
+    if (u)
+      bits += intprec + 1 - (uint)__builtin_clz(u);
+  }
+  return bits;
+}
+
+/* Truncate to p bits (two's complement) and reconstruct at the midpoint */
+static int32 truncate_raw_value(int32 value, uint p)
+{
+  uint shift = 31 - p;
+  int32 q = value >> shift;
+  return (int32)((uint32)q << shift) + (shift ? (int32)1 << (shift - 1) : 0);
+}
+
+uint encode_adaptive_fblock(zfp_output *output, const float *fblock,
+                            float *recon, size_t dim)
+{
+  uint bits = 1;
+  uint i, block_size = BLOCK_SIZE(dim);
+  int emax = get_block_exponent(fblock, block_size);
+  uint maxprec = get_precision(emax, output->maxprec, output->minexp, dim);
+  uint biased_emax = maxprec ? (uint)(emax + EBIAS) : 0;
+
+  if (!biased_emax)
+    return encode_fblock_common(output, output->data, NULL, NULL, emax, 1, 1,
+                                recon, dim);
+
+  int32 iblock[block_size];
+  int32 coeffs[block_size];
+  uint32 ublock[block_size];
+  block_mode mode = block_transform;
+  fwd_cast_block(iblock, fblock, block_size, emax);
+  //* Raw codes only need no transform gain, but have to fit unconstrained.
+  uint rawprec = get_raw_precision(emax, output->maxprec, output->minexp);
+  if (rawprec && block_size * rawprec > output->maxbits - (3 + EBITS))
+    rawprec = 0;
+  if (rawprec) {
+    for (i = 1; i < block_size && iblock[i] == iblock[0]; i++)
+      ;
+    if (i == block_size)
+      mode = block_constant;
+  }
+  if (mode != block_constant) {
+    for (i = 0; i < block_size; i++)
+      coeffs[i] = iblock[i];
+    fwd_decorrelate_block(coeffs, dim);
+    if (rawprec) {
+      fwd_reorder_int2uint(ublock, coeffs, BLOCK_PERM(dim), block_size);
+      if (block_size * rawprec <=
+          estimate_bitplane_bits(ublock, maxprec, block_size))
+        mode = block_raw;
     }
   }
-  //* Return the number of encoded bits.
+
+  if (mode == block_transform)
+    //* Header: one-bit, zero mode bit, exponent.
+    return encode_fblock_common(output, output->data, NULL, coeffs, emax, 1, 1,
+                                recon, dim);
+
+  //* Header: one-bit, one-bit, constant bit, exponent.
+  uint n = mode == block_raw ? block_size : 1;
+  bits += 2 + EBITS;
+  stream_write_bits(output->data,
+                    3 + 4 * (mode == block_constant) + 8 * biased_emax, bits);
+  for (i = 0; i < n; i++)
+    stream_write_bits(output->data, (uint32)(iblock[i] >> (31 - rawprec)),
+                      rawprec);
+  bits += n * rawprec;
+  if (output->minbits > bits) {
+    stream_pad(output->data, output->minbits - bits);
+    bits = output->minbits;
+  }
+  if (recon) {
+    for (i = 0; i < block_size; i++)
+      iblock[i] = truncate_raw_value(iblock[n == 1 ? 0 : i], rawprec);
+    bwd_cast_block(iblock, recon, block_size, emax);
+  }
   return bits;
 }
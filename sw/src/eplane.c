@@ -0,0 +1,177 @@
+// Description: Block exponents in a separate, entropy-coded stream section.
+// Documentation: ./include/eplane.h
+
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "eplane.h"
+#include "decode.h"
+#include "encode.h"
+#include "stream.h"
+
+
+/* Longest unary quotient before an exponent is written verbatim */
+#define RICE_QMAX 16
+/* Number of residuals after which the statistics are halved */
+#define RICE_RESET 64
+
+/* Adaptive Rice parameter estimate (as in LOCO-I) */
+typedef struct {
+  uint sum;   /* sum of the coded residuals */
+  uint count; /* number of coded residuals */
+} rice_state;
+
+static uint get_rice_parameter(const rice_state *r)
+{
+  uint k = 0;
+  while ((r->count << k) < r->sum)
+    k++;
+  return k;
+}
+
+static void update_rice_state(rice_state *r, uint u)
+{
+  r->sum += u;
+  if (++r->count == RICE_RESET) {
+    r->sum >>= 1;
+    r->count >>= 1;
+  }
+}
+
+/* Median edge detector prediction of block (x, y) */
+static int predict_exponent(const uchar *biased, size_t x, size_t y,
+                            size_t bx)
+{
+  const uchar *p = biased + x + bx * y;
+  if (!y)
+    return x ? p[-1] : 0;
+  if (!x)
+    return p[-(ptrdiff_t)bx];
+  int a = p[-1], b = p[-(ptrdiff_t)bx], c = p[-(ptrdiff_t)bx - 1];
+  if (c >= MAX(a, b))
+    return MIN(a, b);
+  if (c <= MIN(a, b))
+    return MAX(a, b);
+  return a + b - c;
+}
+
+/* Map a signed residual to an unsigned one: 0, -1, 1, -2, ... -> 0, 1, 2, ... */
+static uint zigzag(int d)
+{
+  return d < 0 ? 2 * (uint)(-d) - 1 : 2 * (uint)d;
+}
+
+uint64 encode_exponent_plane(stream *s, const uchar *biased, size_t bx,
+                             size_t by)
+{
+  rice_state r = {1, 1};
+  uint64 bits = 0;
+  for (size_t y = 0; y < by; y++)
+    for (size_t x = 0; x < bx; x++) {
+      uint e = biased[x + bx * y];
+      uint u = zigzag((int)e - predict_exponent(biased, x, y, bx));
+      uint k = get_rice_parameter(&r);
+      uint q = u >> k;
+      if (q < RICE_QMAX) {
+        //* Unary quotient (q ones and a zero), then k remainder bits.
+        stream_write_bits(s, ((uint64)1 << q) - 1, q + 1);
+        stream_write_bits(s, u, k);
+        bits += q + 1 + k;
+      } else {
+        //* Escape: RICE_QMAX ones, then the exponent itself.
+        stream_write_bits(s, ((uint64)1 << RICE_QMAX) - 1, RICE_QMAX);
+        stream_write_bits(s, e, EBITS);
+        bits += RICE_QMAX + EBITS;
+      }
+      update_rice_state(&r, u);
+    }
+  return bits;
+}
+
+uint64 decode_exponent_plane(stream *s, uchar *biased, size_t bx, size_t by)
+{
+  rice_state r = {1, 1};
+  uint64 offset = stream_roffset(s);
+  for (size_t y = 0; y < by; y++)
+    for (size_t x = 0; x < bx; x++) {
+      int pred = predict_exponent(biased, x, y, bx);
+      uint k = get_rice_parameter(&r);
+      uint q = 0;
+      uint e;
+      while (q < RICE_QMAX && stream_read_bit(s))
+        q++;
+      if (q < RICE_QMAX) {
+        uint u = (q << k) + (uint)stream_read_bits(s, k);
+        e = (uint)(pred + ((u & 1u) ? -(int)((u + 1) / 2) : (int)(u / 2)));
+      } else {
+        e = (uint)stream_read_bits(s, EBITS);
+      }
+      biased[x + bx * y] = (uchar)e;
+      update_rice_state(&r, zigzag((int)e - pred));
+    }
+  return stream_roffset(s) - offset;
+}
+
+size_t zfp_compress_eplane(zfp_output *output, const zfp_input *input)
+{
+  size_t dim = get_input_dimension(input);
+  if (dim < 1 || dim > 2)
+    //TODO: Implement other dimensions.
+    return 0;
+  if (output->adaptive)
+    //* Only decode_fblock() reads the block header of adaptive streams.
+    return 0;
+  size_t block_size = BLOCK_SIZE(dim);
+  size_t bx = (input->nx + 3) / 4;
+  size_t by = dim > 1 ? (input->ny + 3) / 4 : 1;
+  uchar *biased = (uchar*)malloc(bx * by);
+  float fblock[BLOCK_SIZE_2D];
+
+  //^ Exponent section.
+  for (size_t y = 0; y < by; y++)
+    for (size_t x = 0; x < bx; x++) {
+      gather_input_block(fblock, input, 4 * x, 4 * y, dim);
+      int emax = get_block_exponent(fblock, block_size);
+      uint maxprec = get_precision(emax, output->maxprec, output->minexp, dim);
+      biased[x + bx * y] = maxprec ? (uchar)(emax + EBIAS) : 0;
+    }
+  encode_exponent_plane(output->data, biased, bx, by);
+
+  //^ Bit plane section (blocks are gathered again rather than buffered).
+  for (size_t y = 0; y < by; y++)
+    for (size_t x = 0; x < bx; x++) {
+      gather_input_block(fblock, input, 4 * x, 4 * y, dim);
+      encode_fblock_bitplanes(output, fblock, biased[x + bx * y], dim);
+    }
+
+  free(biased);
+  stream_flush(output->data);
+  return stream_size_bytes(output->data);
+}
+
+size_t zfp_decompress_eplane(zfp_output *output, const zfp_input *input)
+{
+  size_t dim = get_input_dimension(input);
+  if (dim < 1 || dim > 2)
+    //TODO: Implement other dimensions.
+    return 0;
+  if (output->adaptive)
+    //* Only decode_fblock() reads the block header of adaptive streams.
+    return 0;
+  size_t bx = (input->nx + 3) / 4;
+  size_t by = dim > 1 ? (input->ny + 3) / 4 : 1;
+  uchar *biased = (uchar*)malloc(bx * by);
+  float fblock[BLOCK_SIZE_2D];
+
+  decode_exponent_plane(output->data, biased, bx, by);
+  for (size_t y = 0; y < by; y++)
+    for (size_t x = 0; x < bx; x++) {
+      decode_fblock_bitplanes(output, fblock, biased[x + bx * y], dim);
+      scatter_input_block(fblock, input, 4 * x, 4 * y, dim);
+    }
+
+  free(biased);
+  stream_algin_next_word(output->data);
+  return stream_size_bytes(output->data);
+}
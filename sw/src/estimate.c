@@ -0,0 +1,85 @@
+// Description: Compressed size estimation and compression into growable buffers.
+// Documentation: ./include/estimate.h
+
+#include <math.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "estimate.h"
+#include "encode.h"
+#include "stream.h"
+
+
+size_t get_estimated_output_bytes(const zfp_output *output,
+                                  const zfp_input *input, size_t stride,
+                                  double z)
+{
+  size_t dim = get_input_dimension(input);
+  if (dim < 1 || dim > 2)
+    //TODO: Implement other dimensions.
+    return 0;
+  size_t bx = (input->nx + 3) / 4;
+  size_t blocks = get_input_num_blocks(input);
+  if (!blocks)
+    //* Only the spare word of the estimate below.
+    return sizeof(stream_word);
+  uint maxbits = get_max_block_bits(output, input);
+  stride = MAX(stride, (size_t)1);
+  //* A scratch stream large enough for any block.
+  size_t scratch_bytes = (maxbits + 2 * SWORD_BITS) / CHAR_BIT;
+  zfp_output sample = *output;
+  sample.index = NULL;
+  sample.data = stream_init(malloc(scratch_bytes), scratch_bytes);
+  float fblock[BLOCK_SIZE_2D];
+  double sum = 0, sum2 = 0;
+  size_t count = 0;
+
+  for (size_t first = 0; first < blocks; first += stride, count++) {
+    size_t n = MIN(stride, blocks - first);
+    size_t b = first + (size_t)((uint32)(count * 2654435761u) % n);
+    gather_input_block(fblock, input, 4 * (b % bx), 4 * (b / bx), dim);
+    stream_rewind(sample.data);
+    double bits = encode_fblock(&sample, fblock, dim);
+    sum += bits;
+    sum2 += bits * bits;
+  }
+  free(sample.data->begin);
+  free(sample.data);
+
+  double mean = sum / count;
+  double variance = count > 1 ? (sum2 - sum * mean) / (count - 1) : 0;
+  double error = sqrt(MAX(variance, 0.0) / count *
+                      (1 - (double)count / blocks));
+  double bits = blocks * (mean + z * error);
+  bits = MIN(bits, (double)blocks * maxbits);
+  return ((size_t)ceil(bits / SWORD_BITS) + 1) * sizeof(stream_word);
+}
+
+size_t zfp_compress_growable(zfp_output *output, const zfp_input *input)
+{
+  size_t dim = get_input_dimension(input);
+  if (dim < 1 || dim > 2)
+    //TODO: Implement other dimensions.
+    return 0;
+  size_t bx = (input->nx + 3) / 4;
+  size_t blocks = get_input_num_blocks(input);
+  uint maxbits = get_max_block_bits(output, input);
+  stream *s = output->data;
+  float fblock[BLOCK_SIZE_2D];
+
+  for (size_t b = 0; b < blocks; b++) {
+    //* Room for the largest block and the final flush.
+    if ((uint64)(s->end - s->idx) * SWORD_BITS < (uint64)maxbits + SWORD_BITS) {
+      size_t bytes = MAX(2 * stream_capacity_bytes(s), stream_size_bytes(s) +
+                         (maxbits + 2 * SWORD_BITS) / CHAR_BIT);
+      if (!stream_resize(s, bytes))
+        return 0;
+    }
+    gather_input_block(fblock, input, 4 * (b % bx), 4 * (b / bx), dim);
+    encode_fblock(output, fblock, dim);
+  }
+
+  stream_flush(s);
+  return stream_size_bytes(s);
+}
@@ -0,0 +1,76 @@
+// Description: Error-feedback compression of tensor sequences.
+// Documentation: ./include/feedback.h
+
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "feedback.h"
+#include "decode.h"
+#include "encode.h"
+#include "stream.h"
+
+
+zfp_feedback *alloc_zfp_feedback(const zfp_input *input)
+{
+  zfp_feedback *state = (zfp_feedback*)malloc(sizeof(zfp_feedback));
+  if (state) {
+    size_t n = input->nx * MAX(input->ny, (size_t)1);
+    state->nx = input->nx;
+    state->ny = input->ny;
+    state->residual = (float*)calloc(n, sizeof(float));
+  }
+  return state;
+}
+
+void free_zfp_feedback(zfp_feedback *state)
+{
+  if (!state)
+    return;
+  free(state->residual);
+  free(state);
+}
+
+void reset_zfp_feedback(zfp_feedback *state)
+{
+  size_t n = state->nx * MAX(state->ny, (size_t)1);
+  memset(state->residual, 0, n * sizeof(float));
+}
+
+size_t zfp_compress_feedback(zfp_output *output, const zfp_input *input,
+                             zfp_feedback *state)
+{
+  size_t dim = get_input_dimension(input);
+  if (dim < 1 || dim > 2)
+    //TODO: Implement other dimensions.
+    return 0;
+  size_t block_size = BLOCK_SIZE(dim);
+  size_t bx = (input->nx + 3) / 4;
+  size_t blocks = get_input_num_blocks(input);
+  //* The residual is a contiguous tensor of the same shape.
+  zfp_input residual = *input;
+  residual.data = state->residual;
+  residual.sx = residual.sy = 0;
+
+  for (size_t b = 0; b < blocks; b++) {
+    size_t x = 4 * (b % bx), y = 4 * (b / bx);
+    float fblock[BLOCK_SIZE_2D];
+    float rblock[BLOCK_SIZE_2D];
+    uint i;
+
+    gather_input_block(fblock, input, x, y, dim);
+    gather_input_block(rblock, &residual, x, y, dim);
+    for (i = 0; i < block_size; i++) {
+      fblock[i] += rblock[i];
+      rblock[i] = fblock[i];
+    }
+    encode_reconstruct_fblock(output, fblock, dim);
+    for (i = 0; i < block_size; i++)
+      rblock[i] -= fblock[i];
+    scatter_input_block(rblock, &residual, x, y, dim);
+  }
+
+  stream_flush(output->data);
+  return stream_size_bytes(output->data);
+}
@@ -0,0 +1,107 @@
+// Description: Blocks distributed round robin over word-interleaved substreams.
+// Documentation: ./include/lanes.h
+
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "lanes.h"
+#include "decode.h"
+#include "encode.h"
+#include "stream.h"
+
+
+/* Set up one strided output per lane, starting at word `start` of output */
+static void init_lane_outputs(zfp_output *lane, const zfp_output *output,
+                              ptrdiff_t start, uint lanes)
+{
+  for (uint j = 0; j < lanes; j++) {
+    lane[j] = *output;
+    lane[j].index = NULL;
+    //* Lane j owns the words start + j + lanes * w before the end.
+    ptrdiff_t words = MAX(output->data->end - start - (ptrdiff_t)j +
+                          (ptrdiff_t)lanes - 1, (ptrdiff_t)0) / lanes;
+    lane[j].data = stream_init(output->data->begin + start + j,
+                               (size_t)words * sizeof(stream_word));
+    stream_set_stride(lane[j].data, (ptrdiff_t)lanes);
+  }
+}
+
+static void free_lane_outputs(zfp_output *lane, uint lanes)
+{
+  for (uint j = 0; j < lanes; j++)
+    free(lane[j].data);
+}
+
+size_t zfp_compress_lanes(zfp_output *output, const zfp_input *input,
+                          uint lanes)
+{
+  size_t dim = get_input_dimension(input);
+  if (dim < 1 || dim > 2 || !lanes || lanes > ZFP_MAX_LANES)
+    //TODO: Implement other dimensions.
+    return 0;
+  size_t bx = (input->nx + 3) / 4;
+  size_t blocks = get_input_num_blocks(input);
+  zfp_output lane[ZFP_MAX_LANES];
+  float fblock[BLOCK_SIZE_2D];
+
+  //* The header word is written once the lane length is known.
+  stream_flush(output->data);
+  uint64 header = stream_woffset(output->data);
+  ptrdiff_t start = output->data->idx + 1;
+  init_lane_outputs(lane, output, start, lanes);
+  for (size_t b = 0; b < blocks; b++) {
+    gather_input_block(fblock, input, 4 * (b % bx), 4 * (b / bx), dim);
+    encode_fblock(lane + b % lanes, fblock, dim);
+  }
+
+  ptrdiff_t words = 0;
+  for (uint j = 0; j < lanes; j++) {
+    stream_flush(lane[j].data);
+    words = MAX(words, lane[j].data->idx);
+  }
+  for (uint j = 0; j < lanes; j++)
+    while (lane[j].data->idx < words)
+      stream_write_word(lane[j].data, 0);
+  free_lane_outputs(lane, lanes);
+
+  stream_wseek(output->data, header);
+  stream_write_bits(output->data, lanes, 32);
+  stream_write_bits(output->data, (uint64)words, 32);
+  stream_wseek(output->data, (uint64)(start + words * lanes) * SWORD_BITS);
+  return stream_size_bytes(output->data);
+}
+
+size_t zfp_decompress_lanes(zfp_output *output, const zfp_input *input)
+{
+  size_t dim = get_input_dimension(input);
+  if (dim < 1 || dim > 2)
+    //TODO: Implement other dimensions.
+    return 0;
+  size_t bx = (input->nx + 3) / 4;
+  size_t blocks = get_input_num_blocks(input);
+  zfp_output lane[ZFP_MAX_LANES];
+  float fblock[BLOCK_SIZE_2D];
+
+  stream_algin_next_word(output->data);
+  uint lanes = (uint)stream_read_bits(output->data, 32);
+  ptrdiff_t words = (ptrdiff_t)stream_read_bits(output->data, 32);
+  if (!lanes || lanes > ZFP_MAX_LANES)
+    return 0;
+  ptrdiff_t start = output->data->idx;
+  init_lane_outputs(lane, output, start, lanes);
+  for (size_t b = 0; b < blocks; b += lanes) {
+    //* One block per lane and step; a SIMD decoder would map lanes to
+    //* vector lanes here.
+    uint n = (uint)MIN((size_t)lanes, blocks - b);
+    for (uint j = 0; j < n; j++) {
+      size_t i = b + j;
+      decode_fblock(lane + j, fblock, dim);
+      scatter_input_block(fblock, input, 4 * (i % bx), 4 * (i / bx), dim);
+    }
+  }
+  free_lane_outputs(lane, lanes);
+
+  stream_rseek(output->data, (uint64)(start + words * lanes) * SWORD_BITS);
+  return stream_size_bytes(output->data);
+}
@@ -0,0 +1,295 @@
+// Description: Tensor-wide embedded (bit plane interleaved) stream layout.
+// Documentation: ./include/progressive.h
+
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "progressive.h"
+#include "decode.h"
+#include "encode.h"
+#include "stream.h"
+
+
+/* Gather all blocks of the input in raster order */
+static void gather_blocks(float *fblocks, const zfp_input *input, size_t dim)
+{
+  const float *data = (const float*)input->data;
+  size_t nx = input->nx;
+  ptrdiff_t sx = input->sx ? input->sx : 1;
+
+  if (dim == 1) {
+    for (size_t x = 0; x < nx; x += 4, fblocks += 4) {
+      const float *raw = data + sx * (ptrdiff_t)x;
+      if (nx - x < 4)
+        gather_partial_1d_block(fblocks, raw, nx - x, sx);
+      else
+        gather_1d_block(fblocks, raw, sx);
+    }
+    return;
+  }
+
+  size_t ny = input->ny;
+  ptrdiff_t sy = input->sy ? input->sy : (ptrdiff_t)nx;
+  for (size_t y = 0; y < ny; y += 4)
+    for (size_t x = 0; x < nx; x += 4, fblocks += BLOCK_SIZE_2D) {
+      const float *raw = data + sx * (ptrdiff_t)x + sy * (ptrdiff_t)y;
+      if (nx - x < 4 || ny - y < 4)
+        gather_partial_2d_block(fblocks, raw, MIN(nx - x, 4u), MIN(ny - y, 4u),
+                                sx, sy);
+      else
+        gather_2d_block(fblocks, raw, sx, sy);
+    }
+}
+
+/* Scatter all blocks to the input in raster order */
+static void scatter_blocks(const float *fblocks, const zfp_input *input,
+                           size_t dim)
+{
+  float *data = (float*)input->data;
+  size_t nx = input->nx;
+  ptrdiff_t sx = input->sx ? input->sx : 1;
+
+  if (dim == 1) {
+    for (size_t x = 0; x < nx; x += 4, fblocks += 4) {
+      float *raw = data + sx * (ptrdiff_t)x;
+      if (nx - x < 4)
+        scatter_partial_1d_block(fblocks, raw, nx - x, sx);
+      else
+        scatter_1d_block(fblocks, raw, sx);
+    }
+    return;
+  }
+
+  size_t ny = input->ny;
+  ptrdiff_t sy = input->sy ? input->sy : (ptrdiff_t)nx;
+  for (size_t y = 0; y < ny; y += 4)
+    for (size_t x = 0; x < nx; x += 4, fblocks += BLOCK_SIZE_2D) {
+      float *raw = data + sx * (ptrdiff_t)x + sy * (ptrdiff_t)y;
+      if (nx - x < 4 || ny - y < 4)
+        scatter_partial_2d_block(fblocks, raw, MIN(nx - x, 4u), MIN(ny - y, 4u),
+                                 sx, sy);
+      else
+        scatter_2d_block(fblocks, raw, sx, sy);
+    }
+}
+
+/* Encode bit plane x of a block whose first n coefficients are significant */
+static uint encode_bitplane(stream *s, uint64 x, uchar *n, uint block_size)
+{
+  //* Same code as one iteration of encode_all_bitplanes().
+  uint bits = *n;
+  x = stream_write_bits(s, x, *n);
+  for (; *n < block_size; x >>= 1, (*n)++) {
+    bits++;
+    if (!stream_write_bit(s, !!x))
+      break;
+    for (; *n < block_size - 1; x >>= 1, (*n)++) {
+      bits++;
+      if (stream_write_bit(s, x & 1u))
+        break;
+    }
+  }
+  return bits;
+}
+
+/* Decode one bit plane within the remaining budget of bits */
+static uint64 decode_bitplane(stream *s, uchar *n, uint64 *bits,
+                              uint block_size)
+{
+  //* Same code as one iteration of decode_partial_bitplanes().
+  uint m = (uint)MIN((uint64)*n, *bits);
+  *bits -= m;
+  uint64 x = stream_read_bits(s, m);
+  for (; *bits && *n < block_size; (*n)++) {
+    (*bits)--;
+    if (!stream_read_bit(s))
+      break;
+    for (; *bits && *n < block_size - 1; (*n)++) {
+      (*bits)--;
+      if (stream_read_bit(s))
+        break;
+    }
+    x += (uint64)1 << *n;
+  }
+  return x;
+}
+
+/**
+ * @brief Number of interleaved passes and the pass of each block's first plane.
+ * @note Pass j holds the planes of weight 2^(emax - j) with emax the largest
+ *  block exponent, i.e., plane j - first[b] of block b.
+*/
+static uint get_passes(uint *first, const int *emax, const uint *prec,
+                       size_t blocks)
+{
+  int top = -EBIAS;
+  uint passes = 0;
+  for (size_t b = 0; b < blocks; b++)
+    if (prec[b])
+      top = MAX(top, emax[b]);
+  for (size_t b = 0; b < blocks; b++) {
+    first[b] = (uint)(top - emax[b]);
+    if (prec[b])
+      passes = MAX(passes, first[b] + prec[b]);
+  }
+  return passes;
+}
+
+uint64 encode_progressive_blocks(zfp_output *output, const float *fblocks,
+                                 size_t blocks, size_t dim)
+{
+  stream *s = output->data;
+  uint block_size = BLOCK_SIZE(dim);
+  uint intprec = (uint)(CHAR_BIT * sizeof(uint32));
+  uint32 *ublocks = (uint32*)malloc(blocks * block_size * sizeof(uint32));
+  int *emax = (int*)malloc(blocks * sizeof(int));
+  uint *prec = (uint*)malloc(blocks * sizeof(uint));
+  uint *first = (uint*)malloc(blocks * sizeof(uint));
+  uchar *n = (uchar*)calloc(blocks, sizeof(uchar));
+  uint64 bits = 0;
+
+  //^ Header section: transform every block and write its exponent.
+  for (size_t b = 0; b < blocks; b++, fblocks += block_size) {
+    int32 iblock[BLOCK_SIZE_4D];
+    emax[b] = get_block_exponent(fblocks, block_size);
+    prec[b] = get_precision(emax[b], output->maxprec, output->minexp, dim);
+    uint biased_emax = prec[b] ? (uint)(emax[b] + EBIAS) : 0;
+    if (biased_emax) {
+      bits += 1 + EBITS;
+      stream_write_bits(s, 2 * biased_emax + 1, 1 + EBITS);
+      fwd_cast_block(iblock, fblocks, block_size, emax[b]);
+      fwd_decorrelate_block(iblock, dim);
+      fwd_reorder_int2uint(ublocks + b * block_size, iblock, BLOCK_PERM(dim),
+                           block_size);
+    } else {
+      bits++;
+      stream_write_bit(s, 0);
+      prec[b] = 0;
+    }
+  }
+
+  //^ Bit plane section: one pass per plane weight, across all blocks.
+  uint passes = get_passes(first, emax, prec, blocks);
+  for (uint j = 0; j < passes; j++)
+    for (size_t b = 0; b < blocks; b++) {
+      if (j < first[b] || j >= first[b] + prec[b])
+        continue;
+      const uint32 *ublock = ublocks + b * block_size;
+      uint k = intprec - 1 - (j - first[b]);
+      uint64 x = 0;
+      for (uint i = 0; i < block_size; i++)
+        x += (uint64)((ublock[i] >> k) & 1u) << i;
+      bits += encode_bitplane(s, x, n + b, block_size);
+    }
+
+  free(ublocks);
+  free(emax);
+  free(prec);
+  free(first);
+  free(n);
+  return bits;
+}
+
+uint64 decode_progressive_blocks(zfp_output *output, float *fblocks,
+                                 size_t blocks, size_t dim, uint64 maxbits)
+{
+  stream *s = output->data;
+  uint block_size = BLOCK_SIZE(dim);
+  uint intprec = (uint)(CHAR_BIT * sizeof(uint32));
+  uint32 *ublocks = (uint32*)calloc(blocks * block_size, sizeof(uint32));
+  int *emax = (int*)malloc(blocks * sizeof(int));
+  uint *prec = (uint*)calloc(blocks, sizeof(uint));
+  uint *first = (uint*)malloc(blocks * sizeof(uint));
+  uchar *n = (uchar*)calloc(blocks, sizeof(uchar));
+  uint64 bits = maxbits;
+
+  //^ Header section (blocks whose header is cut off stay zero).
+  for (size_t b = 0; b < blocks; b++) {
+    emax[b] = -EBIAS;
+    if (bits < 1 + EBITS) {
+      //* Not enough bits left for a full header.
+      bits = 0;
+      continue;
+    }
+    bits--;
+    if (stream_read_bit(s)) {
+      bits -= EBITS;
+      emax[b] = (int)stream_read_bits(s, EBITS) - EBIAS;
+      prec[b] = get_precision(emax[b], output->maxprec, output->minexp, dim);
+    }
+  }
+
+  //^ Bit plane section, until the budget runs out.
+  uint passes = get_passes(first, emax, prec, blocks);
+  for (uint j = 0; bits && j < passes; j++)
+    for (size_t b = 0; bits && b < blocks; b++) {
+      if (j < first[b] || j >= first[b] + prec[b])
+        continue;
+      uint32 *ublock = ublocks + b * block_size;
+      uint k = intprec - 1 - (j - first[b]);
+      uint64 x = decode_bitplane(s, n + b, &bits, block_size);
+      for (uint i = 0; x; i++, x >>= 1)
+        ublock[i] += (uint32)(x & 1u) << k;
+    }
+
+  //^ Inverse transforms.
+  for (size_t b = 0; b < blocks; b++, fblocks += block_size) {
+    if (prec[b]) {
+      int32 iblock[BLOCK_SIZE_4D];
+      bwd_transform_iblock(ublocks + b * block_size, iblock, dim);
+      bwd_cast_block(iblock, fblocks, block_size, emax[b]);
+    } else {
+      for (uint i = 0; i < block_size; i++)
+        fblocks[i] = 0;
+    }
+  }
+
+  free(ublocks);
+  free(emax);
+  free(prec);
+  free(first);
+  free(n);
+  return maxbits - bits;
+}
+
+size_t zfp_compress_progressive(zfp_output *output, const zfp_input *input)
+{
+  size_t dim = get_input_dimension(input);
+  size_t blocks = get_input_num_blocks(input);
+  if (dim < 1 || dim > 2)
+    //TODO: Implement other dimensions.
+    return 0;
+  if (output->adaptive)
+    //* Only decode_fblock() reads the block header of adaptive streams.
+    return 0;
+
+  float *fblocks = (float*)malloc(blocks * BLOCK_SIZE(dim) * sizeof(float));
+  gather_blocks(fblocks, input, dim);
+  encode_progressive_blocks(output, fblocks, blocks, dim);
+  free(fblocks);
+
+  stream_flush(output->data);
+  return stream_size_bytes(output->data);
+}
+
+size_t zfp_decompress_progressive(zfp_output *output, const zfp_input *input,
+                                  size_t bytes)
+{
+  size_t dim = get_input_dimension(input);
+  size_t blocks = get_input_num_blocks(input);
+  if (dim < 1 || dim > 2)
+    //TODO: Implement other dimensions.
+    return 0;
+  if (output->adaptive)
+    //* Only decode_fblock() reads the block header of adaptive streams.
+    return 0;
+
+  float *fblocks = (float*)malloc(blocks * BLOCK_SIZE(dim) * sizeof(float));
+  uint64 bits = decode_progressive_blocks(output, fblocks, blocks, dim,
+                                          (uint64)bytes * CHAR_BIT);
+  scatter_blocks(fblocks, input, dim);
+  free(fblocks);
+
+  return (size_t)((bits + CHAR_BIT - 1) / CHAR_BIT);
+}
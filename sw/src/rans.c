@@ -0,0 +1,376 @@
+// Description: Adaptive binary rANS coding of the block bits.
+// Documentation: ./include/rans.h
+
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "rans.h"
+#include "decode.h"
+#include "encode.h"
+#include "stream.h"
+
+
+/* Lower bound of a normalized state (states are renormalized 16 bits at a
+   time and stay below 2^31, where the reciprocals below are exact) */
+#define RANS_L ((uint32)1 << 15)
+/* Total frequency of a binary alphabet */
+#define RANS_ONE ((uint32)1 << RANS_PROB_BITS)
+
+/* Kinds of bit plane bits */
+enum { ctx_verbatim, ctx_group, ctx_scan, ctx_kinds };
+
+/* Probabilities (of a one-bit) of every context */
+typedef struct {
+  uint16 zero;                  /* nonzero-block flag */
+  uint16 exponent[1 << EBITS];  /* exponent bits, keyed by the bits above */
+  uint16 plane[ctx_kinds][32][BLOCK_SIZE_2D]; /* by kind, plane and n */
+} rans_model;
+
+/* Upper bound of the symbols of one block (header and 32 bit planes) */
+#define RANS_BLOCK_SYMBOLS(n) (1 + EBITS + 32 * (2 * (n) + 1))
+
+/* Symbols of the encoder, buffered since rANS codes them in reverse */
+typedef struct {
+  uint16 *symbols;  /* probability << 1 | bit of every coded bit */
+  size_t count;     /* number of buffered symbols */
+  size_t capacity;  /* number of allocated symbols */
+} rans_symbols;
+
+/* Division-free x / freq = ((x * rcp) >> 32) >> shift for x < 2^31 */
+typedef struct {
+  uint32 rcp[RANS_ONE];
+  uchar shift[RANS_ONE];
+} rans_reciprocals;
+
+typedef struct {
+  uint32 x[RANS_STATES]; /* interleaved states */
+  const uint16 *words;   /* next word to read */
+  const uint16 *end;     /* end of the coded words */
+  size_t count;          /* number of decoded symbols */
+} rans_decoder;
+
+static void init_rans_model(rans_model *m)
+{
+  uint16 *p = (uint16*)m;
+  for (size_t i = 0; i < sizeof(rans_model) / sizeof(uint16); i++)
+    p[i] = (uint16)(RANS_ONE / 2);
+}
+
+static void init_rans_reciprocals(rans_reciprocals *r)
+{
+  //* Alverson's method; frequencies are never below 2^RANS_ADAPT_SHIFT - 1.
+  for (uint32 freq = 2; freq < RANS_ONE; freq++) {
+    uint shift = 0;
+    while (freq > (1u << shift))
+      shift++;
+    r->rcp[freq] = (uint32)((((uint64)1 << (shift + 31)) + freq - 1) / freq);
+    r->shift[freq] = (uchar)(shift - 1);
+  }
+}
+
+/* Reciprocals of every frequency, built on first use */
+static const rans_reciprocals *get_rans_reciprocals(void)
+{
+  static rans_reciprocals table;
+  static int ready = 0;
+  if (!ready) {
+    init_rans_reciprocals(&table);
+    ready = 1;
+  }
+  return &table;
+}
+
+static void update_probability(uint16 *p, uint bit)
+{
+  //* Stays within [2^RANS_ADAPT_SHIFT - 1, RANS_ONE - 2^RANS_ADAPT_SHIFT + 1].
+  uint32 mask = 0u - bit;
+  *p = (uint16)(*p + (((RANS_ONE - *p) >> RANS_ADAPT_SHIFT) & mask) -
+                ((*p >> RANS_ADAPT_SHIFT) & ~mask));
+}
+
+/* Make room for n more symbols */
+static void reserve_symbols(rans_symbols *e, size_t n)
+{
+  if (e->count + n > e->capacity) {
+    e->capacity = MAX(2 * e->capacity, e->count + n);
+    e->symbols = (uint16*)realloc(e->symbols, e->capacity * sizeof(uint16));
+  }
+}
+
+/* Buffer one bit in context p (room is reserved per block) */
+static uint put_bit(rans_symbols *e, uint16 *p, uint bit)
+{
+  e->symbols[e->count++] = (uint16)(*p << 1 | bit);
+  update_probability(p, bit);
+  return bit;
+}
+
+/* Decode one bit in context p */
+static uint get_bit(rans_decoder *d, uint16 *p)
+{
+  uint32 *x = d->x + (d->count++ & (RANS_STATES - 1));
+  uint32 prob = *p;
+  uint32 slot = *x & (RANS_ONE - 1);
+  uint bit = slot < prob;
+  //* Masks rather than branches: the bits are hard to predict.
+  uint32 mask = 0u - bit;
+  uint32 start = prob & ~mask;
+  uint32 freq = (prob & mask) | ((RANS_ONE - prob) & ~mask);
+  uint32 y = freq * (*x >> RANS_PROB_BITS) + slot - start;
+  //* The next word is always loaded (the buffer is padded) but only
+  //* consumed when the state drops below RANS_L.
+  uint renorm = (y < RANS_L) & (d->words < d->end);
+  uint32 shift = 16 & (0u - renorm);
+  *x = y << shift | (*d->words & (0u - renorm));
+  d->words += renorm;
+  update_probability(p, bit);
+  return bit;
+}
+
+/**
+ * @brief Code the buffered symbols backwards into the words before end.
+ * @return Number of words, at most count + 2 * RANS_STATES.
+*/
+static size_t encode_symbols(uint16 *end, const uint16 *symbols, size_t count)
+{
+  const rans_reciprocals *r = get_rans_reciprocals();
+  uint32 x[RANS_STATES];
+  uint16 *words = end;
+  int j;
+
+  for (j = 0; j < RANS_STATES; j++)
+    x[j] = RANS_L;
+  //* Symbol i goes to state i % RANS_STATES, as in the decoder.
+  for (size_t i = count; i-- > 0;) {
+    uint32 *s = x + (i & (RANS_STATES - 1));
+    uint32 p = symbols[i] >> 1;
+    uint32 mask = 0u - (symbols[i] & 1u);
+    uint32 start = p & ~mask;
+    uint32 freq = (p & mask) | ((RANS_ONE - p) & ~mask);
+    //* Renormalize without a branch; words[-1] is always in the buffer.
+    uint emit = *s >= ((RANS_L >> RANS_PROB_BITS) << 16) * freq;
+    words[-1] = (uint16)*s;
+    words -= emit;
+    *s >>= 16 & (0u - emit);
+    uint32 q = (uint32)(((uint64)*s * r->rcp[freq]) >> 32) >> r->shift[freq];
+    *s = (q << RANS_PROB_BITS) + *s - q * freq + start;
+  }
+  //* The decoder starts by reading the final states.
+  for (j = RANS_STATES; j-- > 0;) {
+    *--words = (uint16)x[j];
+    *--words = (uint16)(x[j] >> 16);
+  }
+  return (size_t)(end - words);
+}
+
+/* Buffer the bits of encode_partial_bitplanes() */
+static uint put_bitplanes(rans_symbols *e, rans_model *m, const uint32 *ublock,
+                          uint maxbits, uint maxprec, uint block_size)
+{
+  uint intprec = (uint)(CHAR_BIT * sizeof(uint32));
+  uint kmin = intprec > maxprec ? intprec - maxprec : 0;
+  uint bits = maxbits;
+  uint i, k, n;
+
+  for (k = intprec, n = 0; bits && k-- > kmin;) {
+    uint16 *verbatim = m->plane[ctx_verbatim][intprec - 1 - k];
+    uint16 *group = m->plane[ctx_group][intprec - 1 - k];
+    uint16 *scan = m->plane[ctx_scan][intprec - 1 - k];
+    uint64 x = 0;
+    for (i = 0; i < block_size; i++)
+      x += (uint64)((ublock[i] >> k) & 1u) << i;
+
+    uint c = MIN(n, bits);
+    bits -= c;
+    for (i = 0; i < c; i++, x >>= 1)
+      put_bit(e, verbatim + i, (uint)(x & 1u));
+
+    for (; bits && n < block_size; x >>= 1, n++) {
+      bits--;
+      if (!put_bit(e, group + n, !!x))
+        break;
+      for (; bits && n < block_size - 1; x >>= 1, n++) {
+        bits--;
+        if (put_bit(e, scan + n, (uint)(x & 1u)))
+          break;
+      }
+    }
+  }
+  return maxbits - bits;
+}
+
+/* Decode the bits of put_bitplanes() as decode_partial_bitplanes() */
+static uint get_bitplanes(rans_decoder *d, rans_model *m, uint32 *ublock,
+                          uint maxbits, uint maxprec, uint block_size)
+{
+  uint intprec = (uint)(CHAR_BIT * sizeof(uint32));
+  uint kmin = intprec > maxprec ? intprec - maxprec : 0;
+  uint bits = maxbits;
+  uint i, k, n;
+
+  for (i = 0; i < block_size; i++)
+    ublock[i] = 0;
+
+  for (k = intprec, n = 0; bits && k-- > kmin;) {
+    uint16 *verbatim = m->plane[ctx_verbatim][intprec - 1 - k];
+    uint16 *group = m->plane[ctx_group][intprec - 1 - k];
+    uint16 *scan = m->plane[ctx_scan][intprec - 1 - k];
+    uint64 x = 0;
+
+    uint c = MIN(n, bits);
+    bits -= c;
+    for (i = 0; i < c; i++)
+      x += (uint64)get_bit(d, verbatim + i) << i;
+
+    for (; bits && n < block_size; n++) {
+      bits--;
+      if (!get_bit(d, group + n))
+        break;
+      for (; bits && n < block_size - 1; n++) {
+        bits--;
+        if (get_bit(d, scan + n))
+          break;
+      }
+      x += (uint64)1 << n;
+    }
+    for (i = 0; x; i++, x >>= 1)
+      ublock[i] += (uint32)(x & 1u) << k;
+  }
+  return maxbits - bits;
+}
+
+/* Buffer the bits of encode_fblock() */
+static void put_fblock(rans_symbols *e, rans_model *m, const zfp_output *output,
+                       const float *fblock, size_t dim)
+{
+  uint block_size = BLOCK_SIZE(dim);
+  int emax = get_block_exponent(fblock, block_size);
+  uint maxprec = get_precision(emax, output->maxprec, output->minexp, dim);
+  uint biased_emax = maxprec ? (uint)(emax + EBIAS) : 0;
+
+  reserve_symbols(e, RANS_BLOCK_SYMBOLS(block_size));
+  if (!put_bit(e, &m->zero, !!biased_emax))
+    return;
+  //* Binary tree over the exponent, from the MSB.
+  for (uint j = EBITS, node = 1; j-- > 0;)
+    node = 2 * node + put_bit(e, m->exponent + node, (biased_emax >> j) & 1u);
+
+  int32 iblock[block_size];
+  uint32 ublock[block_size];
+  fwd_cast_block(iblock, fblock, block_size, emax);
+  fwd_decorrelate_block(iblock, dim);
+  fwd_reorder_int2uint(ublock, iblock, BLOCK_PERM(dim), block_size);
+  put_bitplanes(e, m, ublock, output->maxbits - (1 + EBITS), maxprec,
+                block_size);
+}
+
+/* Decode the bits of put_fblock() */
+static void get_fblock(rans_decoder *d, rans_model *m, const zfp_output *output,
+                       float *fblock, size_t dim)
+{
+  uint block_size = BLOCK_SIZE(dim);
+  uint i;
+
+  if (!get_bit(d, &m->zero)) {
+    for (i = 0; i < block_size; i++)
+      fblock[i] = 0;
+    return;
+  }
+  uint node = 1;
+  for (i = 0; i < EBITS; i++)
+    node = 2 * node + get_bit(d, m->exponent + node);
+  int emax = (int)(node - (1u << EBITS)) - EBIAS;
+  uint maxprec = get_precision(emax, output->maxprec, output->minexp, dim);
+
+  int32 iblock[block_size];
+  uint32 ublock[block_size];
+  get_bitplanes(d, m, ublock, output->maxbits - (1 + EBITS), maxprec,
+                block_size);
+  bwd_transform_iblock(ublock, iblock, dim);
+  bwd_cast_block(iblock, fblock, block_size, emax);
+}
+
+size_t zfp_compress_rans(zfp_output *output, const zfp_input *input)
+{
+  size_t dim = get_input_dimension(input);
+  if (dim < 1 || dim > 2)
+    //TODO: Implement other dimensions.
+    return 0;
+  if (output->adaptive)
+    //* Only decode_fblock() reads the block header of adaptive streams.
+    return 0;
+  size_t bx = (input->nx + 3) / 4;
+  size_t by = dim > 1 ? (input->ny + 3) / 4 : 1;
+  rans_model *m = (rans_model*)malloc(sizeof(rans_model));
+  rans_symbols e;
+  float fblock[BLOCK_SIZE_2D];
+
+  init_rans_model(m);
+  e.count = 0;
+  e.capacity = MAX(bx * by * BLOCK_SIZE(dim), (size_t)64);
+  e.symbols = (uint16*)malloc(e.capacity * sizeof(uint16));
+  for (size_t y = 0; y < by; y++)
+    for (size_t x = 0; x < bx; x++) {
+      gather_input_block(fblock, input, 4 * x, 4 * y, dim);
+      put_fblock(&e, m, output, fblock, dim);
+    }
+
+  size_t capacity = e.count + 2 * RANS_STATES;
+  uint16 *words = (uint16*)malloc(capacity * sizeof(uint16));
+  size_t count = encode_symbols(words + capacity, e.symbols, e.count);
+  const uint16 *begin = words + capacity - count;
+  stream_write_bits(output->data, count & 0xffffffffu, 32);
+  stream_write_bits(output->data, (uint64)count >> 32, 32);
+  for (size_t i = 0; i < count; i++)
+    stream_write_bits(output->data, begin[i], 16);
+
+  free(words);
+  free(e.symbols);
+  free(m);
+  stream_flush(output->data);
+  return stream_size_bytes(output->data);
+}
+
+size_t zfp_decompress_rans(zfp_output *output, const zfp_input *input)
+{
+  size_t dim = get_input_dimension(input);
+  if (dim < 1 || dim > 2)
+    //TODO: Implement other dimensions.
+    return 0;
+  if (output->adaptive)
+    //* Only decode_fblock() reads the block header of adaptive streams.
+    return 0;
+  size_t bx = (input->nx + 3) / 4;
+  size_t by = dim > 1 ? (input->ny + 3) / 4 : 1;
+  rans_model *m = (rans_model*)malloc(sizeof(rans_model));
+  rans_decoder d;
+  float fblock[BLOCK_SIZE_2D];
+
+  size_t count = (size_t)stream_read_bits(output->data, 32);
+  count += (size_t)stream_read_bits(output->data, 32) << 32;
+  uint16 *words = (uint16*)malloc((count + 1) * sizeof(uint16));
+  for (size_t i = 0; i < count; i++)
+    words[i] = (uint16)stream_read_bits(output->data, 16);
+  words[count] = 0;
+
+  init_rans_model(m);
+  d.words = words;
+  d.end = words + count;
+  d.count = 0;
+  for (int j = 0; j < RANS_STATES; j++) {
+    uint32 hi = d.words < d.end ? *d.words++ : 0;
+    uint32 lo = d.words < d.end ? *d.words++ : 0;
+    d.x[j] = hi << 16 | lo;
+  }
+  for (size_t y = 0; y < by; y++)
+    for (size_t x = 0; x < bx; x++) {
+      get_fblock(&d, m, output, fblock, dim);
+      scatter_input_block(fblock, input, 4 * x, 4 * y, dim);
+    }
+
+  free(words);
+  free(m);
+  stream_algin_next_word(output->data);
+  return stream_size_bytes(output->data);
+}
@@ -0,0 +1,102 @@
+// Description: Rate control over windows of blocks sharing a bit budget.
+// Documentation: ./include/rate.h
+
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "rate.h"
+#include "decode.h"
+#include "encode.h"
+#include "stream.h"
+
+
+double set_zfp_output_group_rate(zfp_output *output, double rate,
+                                 double tolerance, uint dim)
+{
+  set_zfp_output_accuracy(output, tolerance);
+  int minexp = output->minexp;
+  double actual = set_zfp_output_rate(output, rate, dim);
+  output->minexp = minexp;
+  return actual;
+}
+
+/* Bits a block may use: its share plus what earlier blocks left unused */
+static uint get_block_budget(uint64 remaining, size_t left, uint maxbits)
+{
+  //* Never borrow from later blocks, so none gets less than maxbits.
+  return (uint)MIN(remaining - (uint64)(left - 1) * maxbits,
+                   (uint64)ZFP_MAX_BITS);
+}
+
+/* Number of blocks per window and mean budget per block */
+static size_t get_window(const zfp_output *output, const zfp_input *input,
+                         size_t window, uint *maxbits)
+{
+  //* Every block needs room for its header.
+  *maxbits = MAX(output->maxbits, 1u + EBITS);
+  return window ? window : (input->nx + 3) / 4;
+}
+
+size_t zfp_compress_group_rate(zfp_output *output, const zfp_input *input,
+                               size_t window)
+{
+  size_t dim = get_input_dimension(input);
+  if (dim < 1 || dim > 2)
+    //TODO: Implement other dimensions.
+    return 0;
+  size_t bx = (input->nx + 3) / 4;
+  size_t blocks = get_input_num_blocks(input);
+  uint maxbits;
+  window = get_window(output, input, window, &maxbits);
+  zfp_output block = *output;
+  block.minbits = 0;
+  block.index = NULL;
+  float fblock[BLOCK_SIZE_2D];
+
+  for (size_t w = 0; w < blocks; w += window) {
+    size_t n = MIN(window, blocks - w);
+    uint64 remaining = (uint64)n * maxbits;
+    for (size_t b = w; b < w + n; b++) {
+      block.maxbits = get_block_budget(remaining, w + n - b, maxbits);
+      gather_input_block(fblock, input, 4 * (b % bx), 4 * (b / bx), dim);
+      remaining -= encode_fblock(&block, fblock, dim);
+    }
+    stream_pad(output->data, remaining);
+  }
+
+  stream_flush(output->data);
+  return stream_size_bytes(output->data);
+}
+
+size_t zfp_decompress_group_rate(zfp_output *output, const zfp_input *input,
+                                 size_t window)
+{
+  size_t dim = get_input_dimension(input);
+  if (dim < 1 || dim > 2)
+    //TODO: Implement other dimensions.
+    return 0;
+  size_t bx = (input->nx + 3) / 4;
+  size_t blocks = get_input_num_blocks(input);
+  uint maxbits;
+  window = get_window(output, input, window, &maxbits);
+  zfp_output block = *output;
+  block.minbits = 0;
+  block.index = NULL;
+  float fblock[BLOCK_SIZE_2D];
+
+  for (size_t w = 0; w < blocks; w += window) {
+    size_t n = MIN(window, blocks - w);
+    uint64 remaining = (uint64)n * maxbits;
+    //* Same caps as the encoder, from the bits read so far.
+    for (size_t b = w; b < w + n; b++) {
+      block.maxbits = get_block_budget(remaining, w + n - b, maxbits);
+      remaining -= decode_fblock(&block, fblock, dim);
+      scatter_input_block(fblock, input, 4 * (b % bx), 4 * (b / bx), dim);
+    }
+    stream_skip(output->data, remaining);
+  }
+
+  stream_algin_next_word(output->data);
+  return stream_size_bytes(output->data);
+}
@@ -0,0 +1,222 @@
+// Description: Zero-block bitmap and run-length coding of zero blocks.
+// Documentation: ./include/sparse.h
+
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+#include "sparse.h"
+#include "decode.h"
+#include "encode.h"
+#include "stream.h"
+
+
+/* Magnitude below which a value has no bit plane to code (0: only zeros) */
+static float get_zero_threshold(const zfp_output *output, uint dim)
+{
+  int e = output->minexp - 2 * (int)dim - 2;
+  //* get_scaler_exponent() clamps subnormal exponents to 1 - EBIAS.
+  return e >= 1 - EBIAS ? LDEXP(1.0f, e) : 0.0f;
+}
+
+/* True if all mx*my values are below the threshold t (or zero if t == 0) */
+static int is_zero_block(const float *raw, size_t mx, size_t my, ptrdiff_t sx,
+                         ptrdiff_t sy, float t)
+{
+  for (size_t y = 0; y < my; y++)
+    for (size_t x = 0; x < mx; x++) {
+      float f = FABS(raw[sx * (ptrdiff_t)x + sy * (ptrdiff_t)y]);
+      //* NaNs fail both tests, as they should.
+      if (t > 0 ? !(f < t) : f != 0)
+        return 0;
+    }
+  return 1;
+}
+
+#ifdef __SSE2__
+/* is_zero_block() for a full block of contiguous rows */
+static int is_zero_block_sse2(const float *raw, ptrdiff_t sy, float t)
+{
+  const __m128 abs = _mm_castsi128_ps(_mm_set1_epi32(0x7fffffff));
+  const __m128 thr = _mm_set1_ps(t);
+  __m128 nonzero = _mm_setzero_ps();
+  for (int y = 0; y < 4; y++, raw += sy) {
+    __m128 v = _mm_and_ps(_mm_loadu_ps(raw), abs);
+    //* Unordered compares flag NaNs as nonzero.
+    nonzero = _mm_or_ps(nonzero, t > 0 ? _mm_cmpnlt_ps(v, thr) :
+                        _mm_cmpneq_ps(v, _mm_setzero_ps()));
+  }
+  return !_mm_movemask_ps(nonzero);
+}
+#endif
+
+size_t get_zero_block_bitmap(uint64 *bitmap, const zfp_output *output,
+                             const zfp_input *input)
+{
+  const float *data = (const float*)input->data;
+  size_t nx = input->nx;
+  size_t ny = input->ny;
+  ptrdiff_t sx = input->sx ? input->sx : 1;
+  ptrdiff_t sy = input->sy ? input->sy : (ptrdiff_t)nx;
+  size_t bx = (nx + 3) / 4;
+  size_t blocks = get_input_num_blocks(input);
+  float t = get_zero_threshold(output, 2);
+  size_t count = 0;
+
+  memset(bitmap, 0, (blocks + 63) / 64 * sizeof(uint64));
+  for (size_t b = 0; b < blocks; b++) {
+    size_t x = 4 * (b % bx), y = 4 * (b / bx);
+    size_t mx = MIN(nx - x, (size_t)4), my = MIN(ny - y, (size_t)4);
+    const float *raw = data + sx * (ptrdiff_t)x + sy * (ptrdiff_t)y;
+    int zero;
+#ifdef __SSE2__
+    if (sx == 1 && mx == 4 && my == 4)
+      zero = is_zero_block_sse2(raw, sy, t);
+    else
+#endif
+      zero = is_zero_block(raw, mx, my, sx, sy, t);
+    if (zero) {
+      bitmap[b / 64] |= (uint64)1 << (b % 64);
+      count++;
+    }
+  }
+  return count;
+}
+
+/* First block at or after b that is not flagged in the bitmap */
+static size_t next_unflagged_block(const uint64 *bitmap, size_t b,
+                                   size_t blocks)
+{
+  while (b < blocks) {
+    uint64 w = ~bitmap[b / 64] >> (b % 64);
+    if (w)
+      return MIN(b + (size_t)__builtin_ctzll(w), blocks);
+    b = (b / 64 + 1) * 64;
+  }
+  return blocks;
+}
+
+/* Write a run of zero blocks: a zero bit and the Elias gamma code of run */
+static void write_zero_run(stream *s, size_t run)
+{
+  uint n = 0;
+  while (run >> (n + 1))
+    n++;
+  stream_write_bit(s, 0);
+  stream_pad(s, n);
+  stream_write_bit(s, 1);
+  stream_write_bits(s, run, n);
+}
+
+/* Clear a run of blocks of the output, one row segment at a time */
+static void clear_block_run(const zfp_input *input, size_t b, size_t run)
+{
+  float *data = (float*)input->data;
+  size_t nx = input->nx;
+  size_t ny = input->ny;
+  ptrdiff_t sx = input->sx ? input->sx : 1;
+  ptrdiff_t sy = input->sy ? input->sy : (ptrdiff_t)nx;
+  size_t bx = (nx + 3) / 4;
+
+  while (run) {
+    size_t i = b % bx, j = b / bx;
+    size_t y0 = 4 * j;
+    size_t n = MIN(run, bx - i);
+    if (!i && run >= bx && sx == 1 && sy == (ptrdiff_t)nx) {
+      //* Whole rows of blocks of a contiguous array: a single memset.
+      n = run / bx * bx;
+      size_t y1 = MIN(y0 + 4 * (n / bx), ny);
+      memset(data + nx * y0, 0, (y1 - y0) * nx * sizeof(float));
+    } else {
+      size_t x0 = 4 * i, x1 = MIN(4 * (i + n), nx);
+      for (size_t y = y0; y < MIN(y0 + 4, ny); y++) {
+        float *row = data + sx * (ptrdiff_t)x0 + sy * (ptrdiff_t)y;
+        if (sx == 1)
+          memset(row, 0, (x1 - x0) * sizeof(float));
+        else
+          for (size_t x = x0; x < x1; x++, row += sx)
+            *row = 0;
+      }
+    }
+    b += n;
+    run -= n;
+  }
+}
+
+size_t zfp_compress_sparse_2d(zfp_output *output, const zfp_input *input)
+{
+  if (get_input_dimension(input) != 2 || output->adaptive)
+    return 0;
+  uint dim = 2;
+  size_t block_size = BLOCK_SIZE(dim);
+  size_t bx = (input->nx + 3) / 4;
+  size_t blocks = get_input_num_blocks(input);
+  uint64 *bitmap = (uint64*)malloc((blocks + 63) / 64 * sizeof(uint64));
+  size_t run = 0;
+
+  get_zero_block_bitmap(bitmap, output, input);
+  for (size_t b = 0; b < blocks;) {
+    //* Flagged blocks are counted without being gathered.
+    size_t next = next_unflagged_block(bitmap, b, blocks);
+    run += next - b;
+    b = next;
+    if (b == blocks)
+      break;
+
+    float fblock[block_size];
+    gather_input_block(fblock, input, 4 * (b % bx), 4 * (b / bx), dim);
+    b++;
+    int emax = get_block_exponent(fblock, block_size);
+    uint maxprec = get_precision(emax, output->maxprec, output->minexp, dim);
+    uint biased_emax = maxprec ? (uint)(emax + EBIAS) : 0;
+    if (!biased_emax) {
+      run++;
+      continue;
+    }
+    if (run) {
+      write_zero_run(output->data, run);
+      run = 0;
+    }
+    stream_write_bits(output->data, 2 * biased_emax + 1, 1 + EBITS);
+    encode_fblock_bitplanes(output, fblock, biased_emax, dim);
+  }
+  if (run)
+    write_zero_run(output->data, run);
+
+  free(bitmap);
+  stream_flush(output->data);
+  return stream_size_bytes(output->data);
+}
+
+size_t zfp_decompress_sparse_2d(zfp_output *output, const zfp_input *input)
+{
+  if (get_input_dimension(input) != 2 || output->adaptive)
+    return 0;
+  uint dim = 2;
+  size_t block_size = BLOCK_SIZE(dim);
+  size_t bx = (input->nx + 3) / 4;
+  size_t blocks = get_input_num_blocks(input);
+
+  for (size_t b = 0; b < blocks;) {
+    if (stream_read_bit(output->data)) {
+      float fblock[block_size];
+      uint biased_emax = (uint)stream_read_bits(output->data, EBITS);
+      decode_fblock_bitplanes(output, fblock, biased_emax, dim);
+      scatter_input_block(fblock, input, 4 * (b % bx), 4 * (b / bx), dim);
+      b++;
+    } else {
+      uint n = stream_scan_zeros(output->data, 64);
+      size_t run = ((size_t)1 << n) + (size_t)stream_read_bits(output->data, n);
+      run = MIN(run, blocks - b);
+      clear_block_run(input, b, run);
+      b += run;
+    }
+  }
+
+  stream_algin_next_word(output->data);
+  return stream_size_bytes(output->data);
+}
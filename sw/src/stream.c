@@ -6,11 +6,7 @@
 stream_word stream_read_word(stream* s)
 {
   // stream_word w = *s->ptr++;
-  stream_word w = s->begin[s->idx++];
-// #ifdef BIT_STREAM_STRIDED
-//   if (!((s->ptr - s->begin) & s->mask))
-//     s->ptr += s->delta;
-// #endif
+  stream_word w = s->begin[s->stride * s->idx++];
   return w;
 }
 
@@ -18,11 +14,10 @@ stream_word stream_read_word(stream* s)
 void stream_write_word(stream* s, stream_word value)
 {
   // *s->ptr++ = value;
-  s->begin[s->idx++] = value;
-// #ifdef BIT_STREAM_STRIDED
-//   if (!((s->ptr - s->begin) & s->mask))
-//     s->ptr += s->delta;
-// #endif
+  //* Words past the end are dropped, but still counted by idx.
+  if (s->idx < s->end)
+    s->begin[s->stride * s->idx] = value;
+  s->idx++;
 }
 
 /* read 0 <= n <= 64 bits */
@@ -105,6 +100,38 @@ uint stream_read_bit(stream *s)
   return bit;
 }
 
+/* Consume 0 <= n <= s->buffered_bits buffered bits */
+static void stream_consume(stream *s, size_t n)
+{
+  s->buffered_bits -= n;
+  s->buffer = n < SWORD_BITS ? s->buffer >> n : 0;
+}
+
+/* Skip up to limit zero-bits and the one-bit that ends them */
+uint stream_scan_zeros(stream *s, uint limit)
+{
+  uint count = 0;
+  while (count < limit) {
+    if (!s->buffered_bits) {
+      s->buffer = stream_read_word(s);
+      s->buffered_bits = SWORD_BITS;
+    }
+    size_t avail = MIN(s->buffered_bits, (size_t)(limit - count));
+    stream_word w = s->buffer;
+    if (avail < SWORD_BITS)
+      w &= ((stream_word)1 << avail) - 1;
+    if (w) {
+      //* The next one-bit is within reach: consume the zeros and the one.
+      uint zeros = (uint)__builtin_ctzll(w);
+      stream_consume(s, zeros + 1);
+      return count + zeros;
+    }
+    stream_consume(s, avail);
+    count += (uint)avail;
+  }
+  return count;
+}
+
 /* Write single bit (must be 0 or 1) */
 uint stream_write_bit(stream* s, uint bit)
 {
@@ -163,6 +190,7 @@ stream *stream_init(void *buffer, size_t bytes)
   if (s) {
     s->begin = (stream_word*)buffer;
     s->end = bytes / sizeof(stream_word);
+    s->stride = 1;
     stream_rewind(s);
   }
   return s;
@@ -173,6 +201,16 @@ size_t stream_capacity_bytes(const stream *s)
   return (size_t)(s->end) * sizeof(stream_word);
 }
 
+stream_word *stream_resize(stream *s, size_t bytes)
+{
+  stream_word *begin = (stream_word*)realloc(s->begin, bytes);
+  if (begin) {
+    s->begin = begin;
+    s->end = bytes / sizeof(stream_word);
+  }
+  return begin;
+}
+
 size_t stream_size_bytes(const stream *s)
 {
   return (size_t)(s->idx) * sizeof(stream_word);
@@ -196,6 +234,23 @@ void stream_rseek(stream* s, uint64 offset)
   }
 }
 
+/* Position stream for writing at given bit offset */
+void stream_wseek(stream* s, uint64 offset)
+{
+  size_t n = (size_t)(offset % SWORD_BITS);
+  s->idx = (size_t)(offset / SWORD_BITS);
+  if (n) {
+    //* Keep the bits of the partial word before the offset (none past the
+    //* end, where words are dropped).
+    stream_word buffer = s->idx < s->end ? s->begin[s->stride * s->idx] : 0;
+    s->buffer = buffer & (((stream_word)1 << n) - 1);
+    s->buffered_bits = n;
+  } else {
+    s->buffer = 0;
+    s->buffered_bits = 0;
+  }
+}
+
 /* Skip over the next n bits (n >= 0) */
 void stream_skip(stream *s, uint64 n)
 {
@@ -209,4 +264,9 @@ size_t stream_algin_next_word(stream *s)
   if (bits)
     stream_skip(s, bits);
   return bits;
-}
\ No newline at end of file
+}
+
+void stream_set_stride(stream *s, ptrdiff_t stride)
+{
+  s->stride = stride;
+}
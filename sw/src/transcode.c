@@ -0,0 +1,151 @@
+// Description: Truncation of compressed arrays in the compressed domain.
+// Documentation: ./include/transcode.h
+
+#include <stddef.h>
+#include <stdio.h>
+
+#include "transcode.h"
+#include "decode.h"
+#include "stream.h"
+
+
+/* Write the n low bits of value, dropping those beyond the remaining budget */
+static void write_bits_capped(stream *s, uint64 value, uint n, uint *bits)
+{
+  uint m = MIN(n, *bits);
+  stream_write_bits(s, value, m);
+  *bits -= m;
+}
+
+uint transcode_bitplanes(stream *dst, stream *src, uint maxbits, uint maxprec,
+                         uint srcbits, uint srcprec, uint block_size)
+{
+  uint intprec = (uint)(CHAR_BIT * sizeof(uint32));
+  uint kmin = intprec > maxprec ? intprec - maxprec : 0;
+  uint ksrc = intprec > srcprec ? intprec - srcprec : 0;
+  //* Unconstrained input blocks hold whole bit planes, so their tail can be
+  //* skipped as soon as the output is complete.
+  int skippable = !exceeded_maxbits(srcbits, srcprec, block_size);
+  uint bits = maxbits;
+  uint sbits = srcbits;
+  uint k, m, n, t;
+
+  //* Parse the input code one bit plane at a time from MSB to LSB, as
+  //* decode_partial_bitplanes() does, and copy it while the output needs it.
+  for (k = intprec, n = 0; sbits && k-- > ksrc;) {
+    if (k < kmin || !bits) {
+      if (skippable) {
+        skip_bitplanes(src, k + 1 - ksrc, n, block_size);
+        break;
+      }
+      //* The input ends at its own budget: keep parsing without writing.
+      bits = 0;
+    }
+
+    //^ Step 1: copy the first n bits of bit plane #k verbatim.
+    m = MIN(n, sbits);
+    sbits -= m;
+    write_bits_capped(dst, stream_read_bits(src, m), m, &bits);
+
+    //^ Step 2: copy the group tests and the runs of zeros they announce.
+    for (; sbits && n < block_size; n++) {
+      sbits--;
+      if (!stream_read_bit(src)) {
+        //* Negative group test -> Done with bit plane.
+        write_bits_capped(dst, 0, 1, &bits);
+        break;
+      }
+      write_bits_capped(dst, 1, 1, &bits);
+      //* Positive group test -> Copy the zeros up to the next one-bit.
+      m = MIN(block_size - 1 - n, sbits);
+      t = stream_scan_zeros(src, m);
+      sbits -= t;
+      write_bits_capped(dst, 0, t, &bits);
+      if (t < m) {
+        sbits--;
+        write_bits_capped(dst, 1, 1, &bits);
+      }
+      n += t;
+    }
+  }
+  return maxbits - bits;
+}
+
+uint transcode_block(zfp_output *dst, zfp_output *src, size_t dim)
+{
+  uint bits = 1;
+  uint srcbits = 1;
+  uint block_size = BLOCK_SIZE(dim);
+  uint64 offset = stream_roffset(src->data);
+
+  if (stream_read_bit(src->data)) {
+    srcbits += EBITS;
+    uint biased_emax = (uint)stream_read_bits(src->data, EBITS);
+    int emax = (int)biased_emax - EBIAS;
+    uint srcprec = get_precision(emax, src->maxprec, src->minexp, dim);
+    uint maxprec = MIN(srcprec, get_precision(emax, dst->maxprec, dst->minexp,
+                                              dim));
+    //* The block becomes zero if all its planes are below the new tolerance.
+    if (maxprec) {
+      bits += EBITS;
+      stream_write_bits(dst->data, 2 * biased_emax + 1, bits);
+    } else {
+      stream_write_bit(dst->data, 0);
+    }
+    bits += transcode_bitplanes(dst->data, src->data,
+                                maxprec ? dst->maxbits - bits : 0, maxprec,
+                                src->maxbits - srcbits, srcprec, block_size);
+  } else {
+    stream_write_bit(dst->data, 0);
+  }
+
+  //* Skip the padding of the input block and pad the output block.
+  uint64 read = stream_roffset(src->data) - offset;
+  if (read < src->minbits)
+    stream_skip(src->data, src->minbits - read);
+  if (bits < dst->minbits) {
+    stream_pad(dst->data, dst->minbits - bits);
+    bits = dst->minbits;
+  }
+  return bits;
+}
+
+/* Copy the next n bits of the input to the output */
+static void copy_bits(stream *dst, stream *src, uint n)
+{
+  //* Half words keep the shifts in stream_write_bits() below 64.
+  uint chunk = (uint)SWORD_BITS / 2;
+  for (; n >= chunk; n -= chunk)
+    stream_write_bits(dst, stream_read_bits(src, chunk), chunk);
+  stream_write_bits(dst, stream_read_bits(src, n), n);
+}
+
+size_t zfp_transcode(zfp_output *dst, zfp_output *src, const zfp_input *input)
+{
+  if (dst->adaptive || src->adaptive)
+    //* Only decode_fblock() reads the block header of adaptive streams.
+    return 0;
+  size_t dim = get_input_dimension(input);
+  size_t blocks = get_input_num_blocks(input);
+
+  //* Only truncation is possible: clamp the output to the input parameters.
+  dst->maxbits = MIN(dst->maxbits, src->maxbits);
+  dst->minbits = MIN(dst->minbits, dst->maxbits);
+  dst->maxprec = MIN(dst->maxprec, src->maxprec);
+  dst->minexp = MAX(dst->minexp, src->minexp);
+
+  if (src->minbits == src->maxbits && dst->minbits == dst->maxbits &&
+      dst->maxprec == src->maxprec && dst->minexp == src->minexp) {
+    //* Fixed rate to fixed rate: each output block is a prefix of the input.
+    for (size_t b = 0; b < blocks; b++) {
+      copy_bits(dst->data, src->data, dst->maxbits);
+      stream_skip(src->data, src->maxbits - dst->maxbits);
+    }
+  } else {
+    for (size_t b = 0; b < blocks; b++)
+      transcode_block(dst, src, dim);
+  }
+
+  stream_flush(dst->data);
+  return stream_size_bytes(dst->data);
+}
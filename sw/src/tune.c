@@ -0,0 +1,136 @@
+// Description: Tolerance tuning from the bit plane statistics of sampled blocks.
+// Documentation: ./include/tune.h
+
+#include <limits.h>
+#include <math.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "tune.h"
+#include "encode.h"
+#include "stream.h"
+
+/* Entries of a bit plane profile (0 to 32 planes) */
+#define PROFILE_SIZE 33
+
+
+zfp_tuner *alloc_zfp_tuner(size_t target_bytes, size_t stride)
+{
+  zfp_tuner *tuner = (zfp_tuner*)malloc(sizeof(zfp_tuner));
+  if (tuner) {
+    tuner->target_bytes = target_bytes;
+    tuner->stride = MAX(stride, (size_t)1);
+    tuner->phase = 0;
+    tuner->minexp = ZFP_MIN_EXP;
+    tuner->tuned = 0;
+    tuner->predicted = 0;
+    tuner->scale = 1;
+  }
+  return tuner;
+}
+
+void free_zfp_tuner(zfp_tuner *tuner)
+{
+  free(tuner);
+}
+
+/* Exponent and bit plane profile of a sampled block (emax -EBIAS: zero) */
+static void profile_block(int *emax, uint *bits, const zfp_input *input,
+                          size_t b, uint dim)
+{
+  uint block_size = BLOCK_SIZE(dim);
+  size_t bx = (input->nx + 3) / 4;
+  float fblock[BLOCK_SIZE_2D];
+  int32 iblock[BLOCK_SIZE_2D];
+  uint32 ublock[BLOCK_SIZE_2D];
+
+  gather_input_block(fblock, input, 4 * (b % bx), 4 * (b / bx), dim);
+  *emax = get_block_exponent(fblock, block_size);
+  fwd_cast_block(iblock, fblock, block_size, *emax);
+  fwd_decorrelate_block(iblock, dim);
+  fwd_reorder_int2uint(ublock, iblock, BLOCK_PERM(dim), block_size);
+  get_bitplane_profile(bits, ublock, block_size);
+}
+
+/* Bits encode_fblock() would write for the samples at a given minexp */
+static double predict_bits(const int *emax, const uint *bits, size_t count,
+                           uint maxprec, int minexp, uint dim)
+{
+  double total = 0;
+  for (size_t i = 0; i < count; i++) {
+    uint p = get_precision(emax[i], maxprec, minexp, dim);
+    uint biased_emax = p ? (uint)(emax[i] + EBIAS) : 0;
+    total += biased_emax ? 1 + EBITS + bits[PROFILE_SIZE * i + MIN(p, 32u)]
+                         : 1;
+  }
+  return total;
+}
+
+double tune_zfp_output_accuracy(zfp_tuner *tuner, zfp_output *output,
+                                const zfp_input *input)
+{
+  uint dim = get_input_dimension(input);
+  if (dim < 1 || dim > 2)
+    //TODO: Implement other dimensions.
+    return 0;
+  size_t blocks = get_input_num_blocks(input);
+  if (!blocks)
+    //* Nothing to sample: keep the current tolerance.
+    return set_zfp_output_accuracy(output, ldexp(1.0, tuner->minexp));
+  size_t phase = tuner->phase % MIN(tuner->stride, blocks);
+  size_t count = (blocks - phase + tuner->stride - 1) / tuner->stride;
+  int *emax = (int*)malloc(count * sizeof(int));
+  uint *bits = (uint*)malloc(count * PROFILE_SIZE * sizeof(uint));
+  int lo = INT_MAX, hi = INT_MIN;
+
+  //* A different subset of blocks is sampled on every call.
+  tuner->phase = phase + 1;
+  for (size_t i = 0; i < count; i++) {
+    profile_block(emax + i, bits + PROFILE_SIZE * i, input,
+                  phase + i * tuner->stride, dim);
+    lo = MIN(lo, emax[i]);
+    hi = MAX(hi, emax[i]);
+  }
+
+  //* Scale the sampled bits to bytes of the whole tensor.
+  double scale = tuner->scale * blocks / (count * (double)CHAR_BIT);
+  double target = (double)tuner->target_bytes;
+  uint maxprec = ZFP_MAX_PREC;
+  double predicted = tuner->tuned ? scale * predict_bits(emax, bits, count,
+                                    maxprec, tuner->minexp, dim) : 0;
+  if (!tuner->tuned || predicted > target ||
+      predicted < (1 - ZFP_TUNE_SLACK) * target) {
+    //* Sizes only shrink as minexp grows: all planes are coded at lo, none
+    //* at hi. Find the smallest minexp that meets the target.
+    lo = MAX(lo - 2 * (int)dim - 2 - 32, ZFP_MIN_EXP);
+    hi = MAX(hi + 2 * (int)dim + 2, lo);
+    predicted = scale * predict_bits(emax, bits, count, maxprec, lo, dim);
+    if (predicted > target) {
+      while (hi - lo > 1) {
+        int mid = lo + (hi - lo) / 2;
+        if (scale * predict_bits(emax, bits, count, maxprec, mid, dim) >
+            target)
+          lo = mid;
+        else
+          hi = mid;
+      }
+      lo = hi;
+      predicted = scale * predict_bits(emax, bits, count, maxprec, lo, dim);
+    }
+    tuner->minexp = lo;
+    tuner->tuned = 1;
+  }
+  tuner->predicted = predicted;
+
+  free(emax);
+  free(bits);
+  return set_zfp_output_accuracy(output, ldexp(1.0, tuner->minexp));
+}
+
+void update_zfp_tuner(zfp_tuner *tuner, size_t bytes)
+{
+  //* Absorbs what the samples miss, e.g., the stream word padding.
+  if (tuner->predicted > 0)
+    tuner->scale *= bytes / tuner->predicted;
+}
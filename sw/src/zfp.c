@@ -1,4 +1,5 @@
 #include <stdio.h>
+#include <stdlib.h>
 
 #include "types.h"
 #include "stream.h"
@@ -7,9 +8,84 @@
 #include "zfp.h"
 
 
+/* Number of bits of the index header: the magic word, the granularity,
+   then the offsets of the recorded blocks but the first */
+static uint64 index_header_bits(const zfp_index *index)
+{
+  return (uint64)(1 + MAX(index->count, (size_t)1)) * SWORD_BITS;
+}
+
+/* Reserve the index header, sizing the index to the input first */
+static uint64 reserve_index_header(zfp_output *output, const zfp_input *input)
+{
+  zfp_index *index = output->index;
+  size_t blocks = get_input_num_blocks(input);
+  //* An index built for another shape would be written out of bounds.
+  if ((blocks + index->granularity - 1) / index->granularity != index->count)
+    index = set_zfp_output_index(output, input, index->granularity);
+  stream_flush(output->data);
+  uint64 header = stream_woffset(output->data);
+  stream_pad(output->data, index_header_bits(index));
+  return header;
+}
+
+/* Fill the header reserved at offset header once the blocks are coded */
+static void write_index_header(zfp_output *output, uint64 header)
+{
+  stream *s = output->data;
+  zfp_index *index = output->index;
+  uint64 end = stream_woffset(s);
+  uint64 base = header + index_header_bits(index);
+
+  stream_wseek(s, header);
+  stream_write_word(s, ZFP_INDEX_MAGIC);
+  stream_write_word(s, (stream_word)index->granularity);
+  //* Offsets relative to the first block, which is not stored.
+  for (size_t g = 1; g < index->count; g++)
+    stream_write_word(s, index->offsets[g] - base);
+  stream_wseek(s, end);
+}
+
+/* Load the index header of a stream into output->index, or drop the index
+   if the stream has none */
+static void read_index_header(zfp_output *output, const zfp_input *input)
+{
+  stream *s = output->data;
+  uint64 start = stream_roffset(s);
+  //* Headers start on a word boundary; a decoder that expects one aligns.
+  if (output->index)
+    stream_algin_next_word(s);
+  uint64 header = stream_roffset(s);
+  if (s->buffered_bits || s->idx >= s->end ||
+      stream_read_word(s) != ZFP_INDEX_MAGIC) {
+    stream_rseek(s, start);
+    if (output->index) {
+      free(output->index->offsets);
+      free(output->index);
+      output->index = NULL;
+    }
+    return;
+  }
+  size_t granularity = (size_t)stream_read_word(s);
+  zfp_index *index = set_zfp_output_index(output, input, granularity);
+  uint64 base = header + index_header_bits(index);
+
+  index->offsets[0] = base;
+  for (size_t g = 1; g < index->count; g++)
+    index->offsets[g] = base + stream_read_word(s);
+}
+
 size_t zfp_compress(zfp_output *output, const zfp_input *input)
 {
+  uint64 header = 0;
+  if (output->index)
+    header = reserve_index_header(output, input);
+  if (output->stats)
+    reset_zfp_stats(output->stats);
   switch (get_input_dimension(input)) {
+    case 1:
+      zfp_compress_1d(output, input);
+      break;
     case 2:
       zfp_compress_2d(output, input);
       break;
@@ -24,10 +100,91 @@ size_t zfp_compress(zfp_output *output, const zfp_input *input)
   }
 
   stream_flush(output->data);
+  if (output->index)
+    write_index_header(output, header);
+  if (output->stats)
+    finish_zfp_stats(output->stats);
   return stream_size_bytes(output->data);
 }
 
 
+/* Record the stream offset of block b if the output keeps an index */
+static void record_block_offset(zfp_output *output, size_t b)
+{
+  zfp_index *index = output->index;
+  if (index && !(b % index->granularity) && b / index->granularity <
+      index->count)
+    index->offsets[b / index->granularity] = stream_woffset(output->data);
+}
+
+/* Encode an mx*my (partial) block, adding its errors to the statistics */
+static void encode_block(zfp_output *output, const float *fblock, size_t mx,
+                         size_t my, size_t dim)
+{
+  zfp_stats *stats = output->stats;
+  if (!stats) {
+    encode_fblock(output, fblock, dim);
+    return;
+  }
+  uint block_size = BLOCK_SIZE(dim);
+  float recon[BLOCK_SIZE_2D];
+  for (uint i = 0; i < block_size; i++)
+    recon[i] = fblock[i];
+  encode_reconstruct_fblock(output, recon, dim);
+  //* The padding of partial blocks is not counted; full blocks take one
+  //* flat loop. Plain comparisons rather than fmax(), a library call.
+  uint n = (uint)(mx * my);
+  double max_error = stats->max_error, sum_error2 = 0;
+  float min = stats->min, max = stats->max;
+  if (n == block_size) {
+    for (uint i = 0; i < n; i++) {
+      double e = fabs((double)recon[i] - fblock[i]);
+      max_error = e > max_error ? e : max_error;
+      sum_error2 += e * e;
+      min = fblock[i] < min ? fblock[i] : min;
+      max = fblock[i] > max ? fblock[i] : max;
+    }
+  } else {
+    for (size_t y = 0; y < my; y++)
+      for (size_t x = 0; x < mx; x++) {
+        float f = fblock[x + 4 * y];
+        double e = fabs((double)recon[x + 4 * y] - f);
+        max_error = e > max_error ? e : max_error;
+        sum_error2 += e * e;
+        min = f < min ? f : min;
+        max = f > max ? f : max;
+      }
+  }
+  stats->max_error = max_error;
+  stats->sum_error2 += sum_error2;
+  stats->min = min;
+  stats->max = max;
+  stats->count += n;
+}
+
+void zfp_compress_1d(zfp_output *output, const zfp_input *input)
+{
+  uint dim = 1;
+  size_t block_size = BLOCK_SIZE(dim);
+  const float* data = (const float*)input->data;
+  size_t nx = input->nx;
+  ptrdiff_t sx = input->sx ? input->sx : 1;
+
+  //* Compress vector one block of 4 values at a time
+  for (size_t x = 0, b = 0; x < nx; x += 4, b++) {
+    const float *raw = data + sx * (ptrdiff_t)x;
+    float fblock[block_size];
+
+    if (nx - x < 4) {
+      gather_partial_1d_block(fblock, raw, nx - x, sx);
+    } else {
+      gather_1d_block(fblock, raw, sx);
+    }
+    record_block_offset(output, b);
+    encode_block(output, fblock, MIN(nx - x, 4u), 1, dim);
+  }
+}
+
 void zfp_compress_2d(zfp_output *output, const zfp_input *input)
 {
   uint dim = 2;
@@ -39,6 +196,7 @@ void zfp_compress_2d(zfp_output *output, const zfp_input *input)
   ptrdiff_t sy = input->sy ? input->sy : (ptrdiff_t)nx;
 
   //* Compress array one block of 4x4 values at a time
+  size_t b = 0;
   for (size_t y = 0; y < ny; y += 4) {
     // printf("Encoding block [%ld, *]\n", y);
     for (size_t x = 0; x < nx; x += 4) {
@@ -50,14 +208,19 @@ void zfp_compress_2d(zfp_output *output, const zfp_input *input)
       } else {
         gather_2d_block(fblock, raw, sx, sy);
       }
-      encode_fblock(output, fblock, dim);
+      record_block_offset(output, b++);
+      encode_block(output, fblock, MIN(nx - x, 4u), MIN(ny - y, 4u), dim);
     }
   }
 }
 
 size_t zfp_decompress(zfp_output *output, const zfp_input *input)
 {
+  read_index_header(output, input);
   switch (get_input_dimension(input)) {
+    case 1:
+      zfp_decompress_1d(output, input);
+      break;
     case 2:
       zfp_decompress_2d(output, input);
       break;
@@ -76,6 +239,28 @@ size_t zfp_decompress(zfp_output *output, const zfp_input *input)
 }
 
 
+void zfp_decompress_1d(zfp_output *output, const zfp_input *input)
+{
+  uint dim = 1;
+  size_t block_size = BLOCK_SIZE(dim);
+  float* data = (float*)input->data;
+  size_t nx = input->nx;
+  ptrdiff_t sx = input->sx ? input->sx : 1;
+
+  //* Decompress vector one block of 4 values at a time
+  for (size_t x = 0; x < nx; x += 4) {
+    float *raw = data + sx * (ptrdiff_t)x;
+    float fblock[block_size];
+
+    decode_fblock(output, fblock, dim);
+    if (nx - x < 4) {
+      scatter_partial_1d_block(fblock, raw, nx - x, sx);
+    } else {
+      scatter_1d_block(fblock, raw, sx);
+    }
+  }
+}
+
 void zfp_decompress_2d(zfp_output *output, const zfp_input *input)
 {
   uint dim = 2;
@@ -101,3 +286,227 @@ void zfp_decompress_2d(zfp_output *output, const zfp_input *input)
     }
   }
 }
+
+/**
+ * @brief Position the stream at block b.
+ * @param next Block the stream is positioned at (updated).
+ * @param base Stream offset of block 0.
+*/
+static void seek_block(zfp_output *output, size_t *next, size_t b, uint64 base,
+                       uint dim)
+{
+  if (b == *next)
+    return;
+  if (output->minbits == output->maxbits) {
+    //* Fixed-rate blocks all have the same length.
+    stream_rseek(output->data, base + (uint64)b * output->maxbits);
+    *next = b;
+    return;
+  }
+  //* Jump to the closest recorded block (or the first block) at or before b.
+  zfp_index *index = output->index;
+  if (index) {
+    size_t g = b / index->granularity;
+    if (b < *next || g * index->granularity > *next) {
+      stream_rseek(output->data, index->offsets[g]);
+      *next = g * index->granularity;
+    }
+  } else if (b < *next) {
+    stream_rseek(output->data, base);
+    *next = 0;
+  }
+  for (; *next < b; (*next)++)
+    skip_fblock(output, dim);
+}
+
+size_t zfp_decompress_window_2d(zfp_output *output, const zfp_input *input,
+                                size_t x0, size_t y0, const zfp_input *window)
+{
+  uint dim = 2;
+  size_t block_size = BLOCK_SIZE(dim);
+  float* data = (float*)window->data;
+  size_t nx = window->nx;
+  size_t ny = window->ny;
+  ptrdiff_t sx = window->sx ? window->sx : 1;
+  ptrdiff_t sy = window->sy ? window->sy : (ptrdiff_t)nx;
+  size_t bx = (input->nx + 3) / 4;
+  size_t next = 0;
+  size_t blocks = 0;
+
+  read_index_header(output, input);
+  uint64 base = stream_roffset(output->data);
+  if (!nx || !ny)
+    return 0;
+  //* Decode only the blocks that intersect the window.
+  for (size_t j = y0 / 4; 4 * j < y0 + ny; j++) {
+    size_t ymin = MAX(4 * j, y0), ymax = MIN(4 * j + 4, y0 + ny);
+    for (size_t i = x0 / 4; 4 * i < x0 + nx; i++, blocks++) {
+      size_t xmin = MAX(4 * i, x0), xmax = MIN(4 * i + 4, x0 + nx);
+      float fblock[block_size];
+
+      seek_block(output, &next, i + bx * j, base, dim);
+      decode_fblock(output, fblock, dim);
+      next++;
+      for (size_t y = ymin; y < ymax; y++)
+        for (size_t x = xmin; x < xmax; x++)
+          data[sx * (ptrdiff_t)(x - x0) + sy * (ptrdiff_t)(y - y0)] =
+            fblock[(x - 4 * i) + 4 * (y - 4 * j)];
+    }
+  }
+  return blocks;
+}
+
+size_t zfp_decompress_accumulate(zfp_output *output, const zfp_input *input,
+                                 float alpha)
+{
+  switch (get_input_dimension(input)) {
+    case 1:
+      zfp_decompress_accumulate_1d(output, input, alpha);
+      break;
+    case 2:
+      zfp_decompress_accumulate_2d(output, input, alpha);
+      break;
+    case 3:
+      //TODO
+      break;
+    case 4:
+      //TODO
+      break;
+    default:
+      break;
+  }
+
+  stream_algin_next_word(output->data);
+  return stream_size_bytes(output->data);
+}
+
+void zfp_decompress_accumulate_1d(zfp_output *output, const zfp_input *input,
+                                  float alpha)
+{
+  uint dim = 1;
+  size_t block_size = BLOCK_SIZE(dim);
+  float* data = (float*)input->data;
+  size_t nx = input->nx;
+  ptrdiff_t sx = input->sx ? input->sx : 1;
+
+  for (size_t x = 0; x < nx; x += 4) {
+    float *raw = data + sx * (ptrdiff_t)x;
+    float fblock[block_size];
+
+    decode_fblock(output, fblock, dim);
+    if (nx - x < 4) {
+      scatter_add_partial_1d_block(fblock, raw, alpha, nx - x, sx);
+    } else {
+      scatter_add_1d_block(fblock, raw, alpha, sx);
+    }
+  }
+}
+
+void zfp_decompress_accumulate_2d(zfp_output *output, const zfp_input *input,
+                                  float alpha)
+{
+  uint dim = 2;
+  size_t block_size = BLOCK_SIZE(dim);
+  float* data = (float*)input->data;
+  size_t nx = input->nx;
+  size_t ny = input->ny;
+  ptrdiff_t sx = input->sx ? input->sx : 1;
+  ptrdiff_t sy = input->sy ? input->sy : (ptrdiff_t)nx;
+
+  //* Decompress array one block of 4x4 values at a time into the destination
+  for (size_t y = 0; y < ny; y += 4) {
+    for (size_t x = 0; x < nx; x += 4) {
+      float *raw = data + sx * (ptrdiff_t)x + sy * (ptrdiff_t)y;
+      float fblock[block_size];
+
+      decode_fblock(output, fblock, dim);
+      if (nx - x < 4 || ny - y < 4) {
+        scatter_add_partial_2d_block(fblock, raw, alpha, MIN(nx - x, 4u),
+                                     MIN(ny - y, 4u), sx, sy);
+      } else {
+        scatter_add_2d_block(fblock, raw, alpha, sx, sy);
+      }
+    }
+  }
+}
+
+size_t zfp_roundtrip(const zfp_output *output, const zfp_input *input)
+{
+  if (output->adaptive)
+    //* The round trip models the regular block header only.
+    return 0;
+  switch (get_input_dimension(input)) {
+    case 1:
+      return zfp_roundtrip_1d(output, input);
+    case 2:
+      return zfp_roundtrip_2d(output, input);
+    case 3:
+      //TODO
+      break;
+    case 4:
+      //TODO
+      break;
+    default:
+      break;
+  }
+  return 0;
+}
+
+size_t zfp_roundtrip_1d(const zfp_output *output, const zfp_input *input)
+{
+  uint dim = 1;
+  size_t block_size = BLOCK_SIZE(dim);
+  float* data = (float*)input->data;
+  size_t nx = input->nx;
+  ptrdiff_t sx = input->sx ? input->sx : 1;
+  size_t bits = 0;
+
+  for (size_t x = 0; x < nx; x += 4) {
+    float *raw = data + sx * (ptrdiff_t)x;
+    float fblock[block_size];
+
+    if (nx - x < 4) {
+      gather_partial_1d_block(fblock, raw, nx - x, sx);
+      bits += roundtrip_fblock(output, fblock, dim);
+      scatter_partial_1d_block(fblock, raw, nx - x, sx);
+    } else {
+      gather_1d_block(fblock, raw, sx);
+      bits += roundtrip_fblock(output, fblock, dim);
+      scatter_1d_block(fblock, raw, sx);
+    }
+  }
+  return bits;
+}
+
+size_t zfp_roundtrip_2d(const zfp_output *output, const zfp_input *input)
+{
+  uint dim = 2;
+  size_t block_size = BLOCK_SIZE(dim);
+  float* data = (float*)input->data;
+  size_t nx = input->nx;
+  size_t ny = input->ny;
+  ptrdiff_t sx = input->sx ? input->sx : 1;
+  ptrdiff_t sy = input->sy ? input->sy : (ptrdiff_t)nx;
+  size_t bits = 0;
+
+  //* Round-trip array one block of 4x4 values at a time
+  for (size_t y = 0; y < ny; y += 4) {
+    for (size_t x = 0; x < nx; x += 4) {
+      float *raw = data + sx * (ptrdiff_t)x + sy * (ptrdiff_t)y;
+      float fblock[block_size];
+
+      if (nx - x < 4 || ny - y < 4) {
+        size_t bx = MIN(nx - x, 4u);
+        size_t by = MIN(ny - y, 4u);
+        gather_partial_2d_block(fblock, raw, bx, by, sx, sy);
+        bits += roundtrip_fblock(output, fblock, dim);
+        scatter_partial_2d_block(fblock, raw, bx, by, sx, sy);
+      } else {
+        gather_2d_block(fblock, raw, sx, sy);
+        bits += roundtrip_fblock(output, fblock, dim);
+        scatter_2d_block(fblock, raw, sx, sy);
+      }
+    }
+  }
+  return bits;
+}
@@ -1,15 +1,52 @@
 #include <stdio.h>
 #include <stdbool.h>
 #include <math.h>
+#include <string.h>
+
+#include <vector>
 
 #include "gtest/gtest.h"
+#include "array2f.hpp"
+#include "algebra.h"
+#include "bfp.h"
+#include "bucket.h"
+#include "cap.h"
+#include "delta.h"
 #include "encode.h"
+#include "estimate.h"
+#include "eplane.h"
+#include "feedback.h"
+#include "lanes.h"
+#include "progressive.h"
+#include "rans.h"
+#include "rate.h"
+#include "sparse.h"
 #include "stream.h"
+#include "transcode.h"
+#include "tune.h"
 #include "zfp.h"
 
 
+class TestZfp1D : public ::testing::TestWithParam<std::tuple<int>> {};
 class TestZfp2D : public ::testing::TestWithParam<std::tuple<int>> {};
 
+void get_input_1d(float *input_data, size_t n)
+{
+  /* initialize vector to be compressed */
+  for (size_t i = 0; i < n; i++) {
+    double x = 2.0 * i / n;
+    input_data[i] = (float)(exp(-x * x) * cos(8 * x));
+  }
+}
+
+double get_max_error(const float *a, const float *b, size_t n)
+{
+  double max_error = 0;
+  for (size_t i = 0; i < n; i++)
+    max_error = fmax(max_error, fabs((double)a[i] - b[i]));
+  return max_error;
+}
+
 void get_input_2d(float *input_data, size_t n)
 {
   size_t nx = n;
@@ -102,10 +139,1392 @@ TEST_P(TestZfp2D, compress)
   cleanup(input, output);
 }
 
+TEST_P(TestZfp1D, roundtrip)
+{
+  size_t n = std::get<0>(GetParam());
+  printf("Testing size: %ld\n", n);
+
+  float *input_data = (float*)malloc(n * sizeof(float));
+  float *output_data = (float*)malloc(n * sizeof(float));
+  get_input_1d(input_data, n);
+
+  zfp_input *input = init_zfp_input(input_data, dtype_float, 1, n);
+  EXPECT_EQ(get_input_dimension(input), 1u);
+  EXPECT_EQ(get_input_num_blocks(input), (n + 3) / 4);
+  zfp_output *output = init_zfp_output(input);
+
+  double tolerance = 1e-3;
+  set_zfp_output_accuracy(output, tolerance);
+  size_t output_size = zfp_compress(output, input);
+  printf("Compressed size:\t%ld bytes\n", output_size);
+
+  stream_rewind(output->data);
+  zfp_input *decoded = init_zfp_input(output_data, dtype_float, 1, n);
+  EXPECT_EQ(zfp_decompress(output, decoded), output_size);
+  EXPECT_LE(get_max_error(input_data, output_data, n), tolerance);
+
+  free_zfp_input(decoded);
+  cleanup(input, output);
+}
+
+INSTANTIATE_TEST_SUITE_P(zfp, TestZfp1D, ::testing::Values(
+                           1, 3, 8, 123, 1000, 65537
+                         ));
+
+TEST(zfp, roundtrip_2d)
+{
+  size_t nx = 123;
+  size_t ny = 45;
+  float *input_data = (float*)malloc(nx * ny * sizeof(float));
+  float *output_data = (float*)malloc(nx * ny * sizeof(float));
+  for (size_t i = 0; i < nx * ny; i++)
+    input_data[i] = (float)sin(0.37 * i) * 3;
+
+  zfp_input *input = init_zfp_input(input_data, dtype_float, 2, nx, ny);
+  zfp_output *output = init_zfp_output(input);
+  double tolerance = 1e-3;
+  set_zfp_output_accuracy(output, tolerance);
+  size_t output_size = zfp_compress(output, input);
+
+  stream_rewind(output->data);
+  zfp_input *decoded = init_zfp_input(output_data, dtype_float, 2, nx, ny);
+  EXPECT_EQ(zfp_decompress(output, decoded), output_size);
+  EXPECT_LE(get_max_error(input_data, output_data, nx * ny), tolerance);
+
+  free_zfp_input(decoded);
+  cleanup(input, output);
+}
+
+/* The fused round trip matches compress + decompress bit for bit */
+void test_roundtrip_2d(size_t nx, size_t ny, zfp_output *output)
+{
+  float *input_data = (float*)malloc(nx * ny * sizeof(float));
+  float *output_data = (float*)malloc(nx * ny * sizeof(float));
+  float *fused_data = (float*)malloc(nx * ny * sizeof(float));
+  for (size_t i = 0; i < nx * ny; i++)
+    input_data[i] = (float)(sin(0.37 * i) * exp(-1e-3 * i));
+  memcpy(fused_data, input_data, nx * ny * sizeof(float));
+
+  zfp_input *input = init_zfp_input(input_data, dtype_float, 2, nx, ny);
+  size_t output_bits = 0;
+  zfp_compress_2d(output, input);
+  output_bits = stream_woffset(output->data);
+  stream_flush(output->data);
+  stream_rewind(output->data);
+  zfp_input *decoded = init_zfp_input(output_data, dtype_float, 2, nx, ny);
+  zfp_decompress_2d(output, decoded);
+
+  zfp_input *fused = init_zfp_input(fused_data, dtype_float, 2, nx, ny);
+  EXPECT_EQ(zfp_roundtrip(output, fused), output_bits);
+  EXPECT_EQ(memcmp(fused_data, output_data, nx * ny * sizeof(float)), 0);
+
+  free_zfp_input(input);
+  free_zfp_input(decoded);
+  free_zfp_input(fused);
+}
+
+TEST(zfp, roundtrip_fused_accuracy)
+{
+  size_t nx = 123, ny = 45;
+  float dummy;
+  zfp_input *shape = init_zfp_input(&dummy, dtype_float, 2, nx, ny);
+  zfp_output *output = init_zfp_output(shape);
+  set_zfp_output_accuracy(output, 1e-4);
+  test_roundtrip_2d(nx, ny, output);
+  shape->data = NULL;
+  cleanup(shape, output);
+}
+
+TEST(zfp, roundtrip_fused_fixed_rate)
+{
+  size_t nx = 123, ny = 45;
+  float dummy;
+  zfp_input *shape = init_zfp_input(&dummy, dtype_float, 2, nx, ny);
+  zfp_output *output = init_zfp_output(shape);
+  //* 4 bits/value forces the rate-constrained bitplane coder.
+  output->minbits = output->maxbits = 4 * BLOCK_SIZE_2D;
+  test_roundtrip_2d(nx, ny, output);
+  shape->data = NULL;
+  cleanup(shape, output);
+}
+
+TEST(zfp, add_compressed_2d)
+{
+  size_t nx = 123, ny = 45, n = nx * ny;
+  double tolerance = 1e-4;
+  float *x = (float*)malloc(n * sizeof(float));
+  float *y = (float*)malloc(n * sizeof(float));
+  float *sum = (float*)malloc(n * sizeof(float));
+  for (size_t i = 0; i < n; i++) {
+    x[i] = (float)sin(0.37 * i);
+    //* Different magnitudes exercise the exponent alignment.
+    y[i] = (float)(i % 7 ? 1e-2 * cos(0.11 * i) : 3 * cos(0.11 * i));
+  }
+
+  zfp_input *xin = init_zfp_input(x, dtype_float, 2, nx, ny);
+  zfp_input *yin = init_zfp_input(y, dtype_float, 2, nx, ny);
+  zfp_input *sumin = init_zfp_input(sum, dtype_float, 2, nx, ny);
+  zfp_output *xout = init_zfp_output(xin);
+  zfp_output *yout = init_zfp_output(yin);
+  zfp_output *sout = init_zfp_output(sumin);
+  set_zfp_output_accuracy(xout, tolerance);
+  set_zfp_output_accuracy(yout, tolerance);
+  set_zfp_output_accuracy(sout, tolerance);
+  zfp_compress(xout, xin);
+  zfp_compress(yout, yin);
+  stream_rewind(xout->data);
+  stream_rewind(yout->data);
+
+  size_t output_size = zfp_add(sout, xout, yout, sumin);
+  printf("Compressed sum:\t%ld bytes\n", output_size);
+  stream_rewind(sout->data);
+  EXPECT_EQ(zfp_decompress(sout, sumin), output_size);
+
+  double max_error = 0;
+  for (size_t i = 0; i < n; i++)
+    max_error = fmax(max_error, fabs((double)x[i] + y[i] - sum[i]));
+  printf("Maximum error:\t\t%g\n", max_error);
+  EXPECT_LE(max_error, 3 * tolerance);
+
+  cleanup(xin, xout);
+  cleanup(yin, yout);
+  cleanup(sumin, sout);
+}
+
+TEST(zfp, decompress_accumulate_2d)
+{
+  size_t nx = 77, ny = 38, n = nx * ny;
+  float alpha = 0.25f;
+  float *x = (float*)malloc(n * sizeof(float));
+  float *decoded = (float*)malloc(n * sizeof(float));
+  float *acc = (float*)malloc(n * sizeof(float));
+  for (size_t i = 0; i < n; i++) {
+    x[i] = (float)sin(0.37 * i);
+    acc[i] = (float)i;
+  }
+
+  zfp_input *input = init_zfp_input(x, dtype_float, 2, nx, ny);
+  zfp_output *output = init_zfp_output(input);
+  set_zfp_output_accuracy(output, 1e-4);
+  size_t output_size = zfp_compress(output, input);
+
+  stream_rewind(output->data);
+  zfp_input *dinput = init_zfp_input(decoded, dtype_float, 2, nx, ny);
+  zfp_decompress(output, dinput);
+  stream_rewind(output->data);
+  zfp_input *ainput = init_zfp_input(acc, dtype_float, 2, nx, ny);
+  EXPECT_EQ(zfp_decompress_accumulate(output, ainput, alpha), output_size);
+
+  for (size_t i = 0; i < n; i++)
+    EXPECT_FLOAT_EQ(acc[i], (float)i + alpha * decoded[i]);
+
+  free_zfp_input(dinput);
+  free_zfp_input(ainput);
+  cleanup(input, output);
+}
+
+TEST(zfp, reduce_compressed_2d)
+{
+  size_t nx = 123, ny = 45, n = nx * ny;
+  float *x = (float*)malloc(n * sizeof(float));
+  float *y = (float*)malloc(n * sizeof(float));
+  float *xd = (float*)malloc(n * sizeof(float));
+  float *yd = (float*)malloc(n * sizeof(float));
+  for (size_t i = 0; i < n; i++) {
+    x[i] = (float)sin(0.37 * i);
+    y[i] = (float)cos(0.11 * i) * 1e-2f;
+  }
+
+  zfp_input *xin = init_zfp_input(x, dtype_float, 2, nx, ny);
+  zfp_input *yin = init_zfp_input(y, dtype_float, 2, nx, ny);
+  zfp_output *xout = init_zfp_output(xin);
+  zfp_output *yout = init_zfp_output(yin);
+  set_zfp_output_accuracy(xout, 1e-5);
+  set_zfp_output_accuracy(yout, 1e-5);
+  zfp_compress(xout, xin);
+  zfp_compress(yout, yin);
+
+  //* Reference: reductions over the decompressed arrays.
+  zfp_input *xdin = init_zfp_input(xd, dtype_float, 2, nx, ny);
+  zfp_input *ydin = init_zfp_input(yd, dtype_float, 2, nx, ny);
+  stream_rewind(xout->data);
+  stream_rewind(yout->data);
+  zfp_decompress(xout, xdin);
+  zfp_decompress(yout, ydin);
+  double sum = 0, sumsq = 0, dot = 0;
+  for (size_t i = 0; i < n; i++) {
+    sum += xd[i];
+    sumsq += (double)xd[i] * xd[i];
+    dot += (double)xd[i] * yd[i];
+  }
+
+  zfp_reduction r;
+  stream_rewind(xout->data);
+  zfp_reduce(xout, xin, ZFP_MAX_PREC, &r);
+  EXPECT_EQ(r.count, n);
+  EXPECT_NEAR(r.sum, sum, 1e-6 * n);
+  EXPECT_NEAR(r.sumsq, sumsq, 1e-6 * sumsq);
+  EXPECT_EQ(r.error, 0);
+
+  stream_rewind(xout->data);
+  stream_rewind(yout->data);
+  EXPECT_NEAR(zfp_dot(xout, yout, xin, ZFP_MAX_PREC), dot, 1e-6 * fabs(dot) + 1e-9);
+
+  //* Approximate mode: the top planes bound the norm.
+  zfp_reduction approx;
+  stream_rewind(xout->data);
+  zfp_reduce(xout, xin, 8, &approx);
+  printf("L2 norm:\t\t%f (approx. %f +- %f)\n", sqrt(sumsq),
+         sqrt(approx.sumsq), approx.error);
+  EXPECT_GT(approx.error, 0);
+  EXPECT_LE(sqrt(sumsq), sqrt(approx.sumsq) + approx.error);
+  EXPECT_GE(sqrt(sumsq), sqrt(approx.sumsq) - approx.error);
+
+  free_zfp_input(xdin);
+  free_zfp_input(ydin);
+  cleanup(xin, xout);
+  cleanup(yin, yout);
+}
+
+/* Decode at every read precision and check error and stream position */
+void test_read_precision_2d(zfp_output *output, size_t nx, size_t ny)
+{
+  size_t n = nx * ny;
+  float *x = (float*)malloc(n * sizeof(float));
+  float *full = (float*)malloc(n * sizeof(float));
+  float *part = (float*)malloc(n * sizeof(float));
+  for (size_t i = 0; i < n; i++)
+    x[i] = (float)(sin(0.37 * i) + 1e-3 * cos(3.1 * i));
+
+  zfp_input *input = init_zfp_input(x, dtype_float, 2, nx, ny);
+  zfp_input *finput = init_zfp_input(full, dtype_float, 2, nx, ny);
+  zfp_input *pinput = init_zfp_input(part, dtype_float, 2, nx, ny);
+  size_t output_size = zfp_compress(output, input);
+  stream_rewind(output->data);
+  zfp_decompress(output, finput);
+
+  double last_error = INFINITY;
+  uint precs[] = {2, 4, 8, 12, 16, 24, ZFP_MAX_PREC};
+  for (uint p = 0; p < sizeof(precs) / sizeof(precs[0]); p++) {
+    set_zfp_output_read_precision(output, precs[p]);
+    stream_rewind(output->data);
+    EXPECT_EQ(zfp_decompress(output, pinput), output_size);
+    double error = get_max_error(full, part, n);
+    printf("readprec %2u:\tmax error %g\n", precs[p], error);
+    EXPECT_LE(error, last_error);
+    last_error = error;
+  }
+  EXPECT_EQ(last_error, 0);
+
+  free_zfp_input(finput);
+  free_zfp_input(pinput);
+  free_zfp_input(input);
+}
+
+TEST(zfp, read_precision_accuracy)
+{
+  size_t nx = 123, ny = 45;
+  zfp_input *shape = init_zfp_input(NULL, dtype_float, 2, nx, ny);
+  zfp_output *output = init_zfp_output(shape);
+  set_zfp_output_accuracy(output, 1e-6);
+  test_read_precision_2d(output, nx, ny);
+  cleanup(shape, output);
+}
+
+TEST(zfp, read_precision_fixed_rate)
+{
+  size_t nx = 123, ny = 45;
+  zfp_input *shape = init_zfp_input(NULL, dtype_float, 2, nx, ny);
+  zfp_output *output = init_zfp_output(shape);
+  output->minbits = output->maxbits = 12 * BLOCK_SIZE_2D;
+  test_read_precision_2d(output, nx, ny);
+  cleanup(shape, output);
+}
+
+/* Transcode src to dst and compare with compressing directly with ref */
+void test_transcode_2d(zfp_output *src, zfp_output *dst, zfp_output *ref,
+                       size_t nx, size_t ny)
+{
+  size_t n = nx * ny;
+  float *x = (float*)malloc(n * sizeof(float));
+  for (size_t i = 0; i < n; i++)
+    x[i] = (float)(sin(0.37 * i) + 1e-3 * cos(3.1 * i));
+  zfp_input *input = init_zfp_input(x, dtype_float, 2, nx, ny);
+
+  size_t src_size = zfp_compress(src, input);
+  size_t ref_size = zfp_compress(ref, input);
+  stream_rewind(src->data);
+  size_t dst_size = zfp_transcode(dst, src, input);
+  printf("Transcoded %zu -> %zu bytes\n", src_size, dst_size);
+  ASSERT_EQ(dst_size, ref_size);
+  EXPECT_EQ(memcmp(dst->data->begin, ref->data->begin, dst_size), 0);
+
+  free_zfp_input(input);
+}
+
+TEST(zfp, transcode_accuracy)
+{
+  size_t nx = 123, ny = 45;
+  zfp_input *shape = init_zfp_input(NULL, dtype_float, 2, nx, ny);
+  zfp_output *src = init_zfp_output(shape);
+  zfp_output *dst = init_zfp_output(shape);
+  zfp_output *ref = init_zfp_output(shape);
+  set_zfp_output_accuracy(src, 1e-6);
+  set_zfp_output_accuracy(dst, 1e-3);
+  set_zfp_output_accuracy(ref, 1e-3);
+  test_transcode_2d(src, dst, ref, nx, ny);
+  free_zfp_output(src);
+  free_zfp_output(dst);
+  cleanup(shape, ref);
+}
+
+TEST(zfp, transcode_fixed_rate)
+{
+  size_t nx = 123, ny = 45;
+  zfp_input *shape = init_zfp_input(NULL, dtype_float, 2, nx, ny);
+  zfp_output *src = init_zfp_output(shape);
+  zfp_output *dst = init_zfp_output(shape);
+  zfp_output *ref = init_zfp_output(shape);
+  set_zfp_output_rate(src, 12, 2);
+  set_zfp_output_rate(dst, 5, 2);
+  set_zfp_output_rate(ref, 5, 2);
+  test_transcode_2d(src, dst, ref, nx, ny);
+  free_zfp_output(src);
+  free_zfp_output(dst);
+  cleanup(shape, ref);
+}
+
+TEST(zfp, transcode_accuracy_to_fixed_rate)
+{
+  size_t nx = 123, ny = 45;
+  zfp_input *shape = init_zfp_input(NULL, dtype_float, 2, nx, ny);
+  zfp_output *src = init_zfp_output(shape);
+  zfp_output *dst = init_zfp_output(shape);
+  zfp_output *ref = init_zfp_output(shape);
+  set_zfp_output_accuracy(src, 1e-5);
+  set_zfp_output_rate(dst, 6, 2);
+  //* The output keeps the tolerance of the input.
+  set_zfp_output_rate(ref, 6, 2);
+  ref->minexp = src->minexp;
+  test_transcode_2d(src, dst, ref, nx, ny);
+  free_zfp_output(src);
+  free_zfp_output(dst);
+  cleanup(shape, ref);
+}
+
+TEST(zfp, progressive_2d)
+{
+  size_t nx = 123, ny = 45, n = nx * ny;
+  float *x = (float*)malloc(n * sizeof(float));
+  float *y = (float*)malloc(n * sizeof(float));
+  float *z = (float*)malloc(n * sizeof(float));
+  for (size_t i = 0; i < n; i++)
+    x[i] = (float)((1 + i / nx) * sin(0.37 * i) + 1e-3 * cos(3.1 * i));
+  zfp_input *input = init_zfp_input(x, dtype_float, 2, nx, ny);
+  zfp_input *yin = init_zfp_input(y, dtype_float, 2, nx, ny);
+  zfp_input *zin = init_zfp_input(z, dtype_float, 2, nx, ny);
+  zfp_output *output = init_zfp_output(input);
+  zfp_output *regular = init_zfp_output(input);
+  set_zfp_output_accuracy(output, 1e-5);
+  set_zfp_output_accuracy(regular, 1e-5);
+
+  //* Same bits as a regular stream, only reordered.
+  size_t output_size = zfp_compress_progressive(output, input);
+  EXPECT_EQ(output_size, zfp_compress(regular, input));
+  stream_rewind(regular->data);
+  zfp_decompress(regular, zin);
+
+  //* Any prefix decodes, with an error that drops as more bytes arrive.
+  double last_error = INFINITY;
+  for (size_t bytes = output_size / 16; bytes < output_size; bytes *= 2) {
+    stream_rewind(output->data);
+    EXPECT_EQ(zfp_decompress_progressive(output, yin, bytes), bytes);
+    double error = get_max_error(x, y, n);
+    printf("%zu/%zu bytes:\tmax error %g\n", bytes, output_size, error);
+    EXPECT_LT(error, last_error);
+    last_error = error;
+  }
+  stream_rewind(output->data);
+  zfp_decompress_progressive(output, yin, output_size);
+  EXPECT_EQ(get_max_error(y, z, n), 0);
+
+  free_zfp_input(yin);
+  free_zfp_input(zin);
+  free_zfp_output(regular);
+  cleanup(input, output);
+}
+
+TEST(zfp, compressed_array2f)
+{
+  size_t nx = 123, ny = 45, n = nx * ny;
+  float *x = (float*)malloc(n * sizeof(float));
+  float *z = (float*)malloc(n * sizeof(float));
+  for (size_t i = 0; i < n; i++)
+    x[i] = (float)(sin(0.37 * i) + 1e-3 * cos(3.1 * i));
+  zfp_input *input = init_zfp_input(x, dtype_float, 2, nx, ny);
+  zfp_input *zin = init_zfp_input(z, dtype_float, 2, nx, ny);
+
+  //* One row of blocks fits in the cache, so each block is encoded once.
+  compressed_array2f a(nx, ny, 10, (nx + 3) / 4 + 1);
+  EXPECT_EQ(a.rate(), 12);
+  for (size_t y = 0; y < ny; y++)
+    for (size_t i = 0; i < nx; i++)
+      a(i, y) = x[i + nx * y];
+
+  //* Same layout as a fixed-rate stream of the array.
+  zfp_output *output = init_zfp_output(input);
+  set_zfp_output_rate(output, a.rate(), 2);
+  ASSERT_EQ(zfp_compress(output, input), a.compressed_bytes());
+  EXPECT_EQ(memcmp(output->data->begin, a.compressed_data(),
+                   a.compressed_bytes()), 0);
+  stream_rewind(output->data);
+  zfp_decompress(output, zin);
+
+  //* Reads decode the same values as the array decompressor.
+  compressed_array2f b(nx, ny, a.rate(), 4);
+  b.set(x);
+  const compressed_array2f &cb = b;
+  for (size_t y = 0; y < ny; y++)
+    for (size_t i = 0; i < nx; i++)
+      ASSERT_EQ(cb(i, y), z[i + nx * y]);
+  b(7, 3) += 1;
+  EXPECT_EQ(b(7, 3), z[7 + nx * 3] + 1);
+
+  //* A tiny cache re-encodes blocks on every eviction, but stays accurate.
+  compressed_array2f c(nx, ny, a.rate(), 2);
+  for (size_t y = 0; y < ny; y++)
+    for (size_t i = 0; i < nx; i++)
+      c(i, y) = x[i + nx * y];
+  c.get(z);
+  printf("Max error (2 cached blocks): %g\n", get_max_error(x, z, n));
+  EXPECT_LT(get_max_error(x, z, n), 1e-2);
+
+  free_zfp_input(zin);
+  cleanup(input, output);
+}
+
+/* Decode a window into a strided buffer and compare with a full decode */
+void test_window_2d(zfp_output *output, size_t granularity)
+{
+  size_t nx = 123, ny = 45, n = nx * ny;
+  size_t x0 = 37, y0 = 13, wx = 50, wy = 21, pitch = wx + 5;
+  float *x = (float*)malloc(n * sizeof(float));
+  float *z = (float*)malloc(n * sizeof(float));
+  float *w = (float*)calloc(pitch * wy, sizeof(float));
+  for (size_t i = 0; i < n; i++)
+    x[i] = (float)(sin(0.37 * i) + 1e-3 * cos(3.1 * i));
+  zfp_input *input = init_zfp_input(x, dtype_float, 2, nx, ny);
+  zfp_input *zin = init_zfp_input(z, dtype_float, 2, nx, ny);
+  zfp_input *window = init_zfp_input(w, dtype_float, 2, wx, wy);
+  window->sy = (ptrdiff_t)pitch;
+  //* Sized for the window on purpose: zfp_compress() resizes it.
+  if (granularity)
+    set_zfp_output_index(output, window, granularity);
+
+  size_t output_size = zfp_compress(output, input);
+  if (granularity) {
+    EXPECT_EQ(output->index->count, (31 * 12 + granularity - 1) / granularity);
+  }
+  stream_rewind(output->data);
+  EXPECT_EQ(zfp_decompress(output, zin), output_size);
+
+  //* A receiver only has the bytes and the compression parameters: the
+  //* offsets come from the stream. An index it sets on a stream without
+  //* one is dropped.
+  zfp_output *receiver = init_zfp_output(input);
+  receiver->minbits = output->minbits;
+  receiver->maxbits = output->maxbits;
+  receiver->maxprec = output->maxprec;
+  receiver->minexp = output->minexp;
+  receiver->readprec = output->readprec;
+  memcpy(receiver->data->begin, output->data->begin, output_size);
+  if (!granularity)
+    set_zfp_output_index(receiver, input, 1);
+  //* Blocks [9, 21] x [3, 8] intersect the window.
+  EXPECT_EQ(zfp_decompress_window_2d(receiver, input, x0, y0, window),
+            13u * 6);
+  EXPECT_EQ(receiver->index != NULL, granularity != 0);
+  if (granularity) {
+    EXPECT_EQ(receiver->index->granularity, granularity);
+    for (size_t g = 0; g < output->index->count; g++)
+      EXPECT_EQ(receiver->index->offsets[g], output->index->offsets[g]);
+  }
+  for (size_t y = 0; y < wy; y++)
+    for (size_t i = 0; i < wx; i++)
+      ASSERT_EQ(w[i + pitch * y], z[(x0 + i) + nx * (y0 + y)]);
+
+  free_zfp_output(receiver);
+  free_zfp_input(zin);
+  free_zfp_input(window);
+  free_zfp_input(input);
+}
+
+TEST(zfp, window_2d)
+{
+  zfp_input *shape = init_zfp_input(NULL, dtype_float, 2, 123, 45);
+  //* Accuracy mode without an index, with one offset per row of blocks, and
+  //* with one offset per block.
+  size_t granularity[] = {0, 31, 1};
+  for (size_t g = 0; g < 3; g++) {
+    zfp_output *output = init_zfp_output(shape);
+    set_zfp_output_accuracy(output, 1e-4);
+    test_window_2d(output, granularity[g]);
+    free_zfp_output(output);
+  }
+  //* Fixed-rate blocks are located without an index.
+  zfp_output *output = init_zfp_output(shape);
+  set_zfp_output_rate(output, 7, 2);
+  test_window_2d(output, 0);
+  cleanup(shape, output);
+}
+
+TEST(zfp, delta_sequence)
+{
+  size_t nx = 123, ny = 45, n = nx * ny;
+  double tolerance = 1e-4;
+  float *x = (float*)malloc(n * sizeof(float));
+  float *y = (float*)malloc(n * sizeof(float));
+  for (size_t i = 0; i < n; i++)
+    x[i] = (float)(sin(0.37 * i) + 1e-3 * cos(3.1 * i));
+  zfp_input *input = init_zfp_input(x, dtype_float, 2, nx, ny);
+  zfp_input *decoded = init_zfp_input(y, dtype_float, 2, nx, ny);
+  zfp_output *output = init_zfp_output(input);
+  set_zfp_output_accuracy(output, tolerance);
+  zfp_delta *encoder = alloc_zfp_delta(input, 4);
+  zfp_delta *decoder = alloc_zfp_delta(input, 4);
+
+  size_t delta_bytes = 0, plain_bytes = 0;
+  for (uint t = 0; t < 8; t++) {
+    //* A small update per iteration.
+    for (size_t i = 0; i < n; i++)
+      x[i] += (float)(1e-3 * sin(0.11 * i * (t + 1)));
+
+    stream_rewind(output->data);
+    plain_bytes += zfp_compress(output, input);
+    stream_rewind(output->data);
+    size_t bytes = zfp_compress_delta(output, input, encoder);
+    delta_bytes += bytes;
+    stream_rewind(output->data);
+    EXPECT_EQ(zfp_decompress_delta(output, decoded, decoder), bytes);
+    printf("Frame %u:\t%zu bytes\n", t, bytes);
+
+    //* The decoder mirrors the encoder state and meets the tolerance.
+    EXPECT_EQ(memcmp(y, encoder->reference, n * sizeof(float)), 0);
+    EXPECT_EQ(memcmp(y, decoder->reference, n * sizeof(float)), 0);
+    EXPECT_LE(get_max_error(x, y, n), tolerance);
+  }
+  printf("Delta: %zu bytes, independent: %zu bytes\n", delta_bytes,
+         plain_bytes);
+  EXPECT_LT(delta_bytes, plain_bytes * 3 / 4);
+
+  free_zfp_delta(encoder);
+  free_zfp_delta(decoder);
+  free_zfp_input(decoded);
+  cleanup(input, output);
+}
+
+/**
+ * Alternative layouts of an nx x ny array x: y receives the values decoded
+ * from the layout, z those of a regular stream with the same parameters.
+*/
+class TestLayout2D : public ::testing::Test {
+protected:
+  size_t nx = 0, ny = 0, n = 0;
+  float *x = NULL, *y = NULL, *z = NULL;
+  zfp_input *input = NULL, *yin = NULL, *zin = NULL;
+
+  void init(size_t width, size_t height)
+  {
+    nx = width;
+    ny = height;
+    n = nx * ny;
+    x = (float*)malloc(n * sizeof(float));
+    y = (float*)malloc(n * sizeof(float));
+    z = (float*)malloc(n * sizeof(float));
+    input = init_zfp_input(x, dtype_float, 2, nx, ny);
+    yin = init_zfp_input(y, dtype_float, 2, nx, ny);
+    zin = init_zfp_input(z, dtype_float, 2, nx, ny);
+  }
+
+  void TearDown() override
+  {
+    if (input) {
+      free_zfp_input(yin);
+      free_zfp_input(zin);
+      free_zfp_input(input);
+    }
+  }
+
+  /* Round-trip x through a transform-only stream with the parameters of
+     output into z; returns the size of that stream */
+  size_t compress_regular(const zfp_output *output)
+  {
+    zfp_output *regular = init_zfp_output(input);
+    regular->minbits = output->minbits;
+    regular->maxbits = output->maxbits;
+    regular->maxprec = output->maxprec;
+    regular->minexp = output->minexp;
+    size_t regular_size = zfp_compress(regular, input);
+    stream_rewind(regular->data);
+    EXPECT_EQ(zfp_decompress(regular, zin), regular_size);
+    free_zfp_output(regular);
+    return regular_size;
+  }
+
+  void report(const char *layout, size_t size, size_t regular_size)
+  {
+    printf("%s: %zu bytes, regular: %zu bytes\n", layout, size,
+           regular_size);
+  }
+
+  /* The layout decodes to exactly what the regular stream does */
+  void expect_regular_values()
+  {
+    EXPECT_EQ(memcmp(y, z, n * sizeof(float)), 0);
+  }
+};
+
+TEST_F(TestLayout2D, exponent_plane_2d)
+{
+  init(123, 45);
+  //* Gradient-like values: small, with a slowly varying magnitude.
+  for (size_t i = 0; i < n; i++)
+    x[i] = (float)(1e-3 * exp(-1e-3 * i) * sin(0.37 * i));
+  zfp_output *output = init_zfp_output(input);
+  set_zfp_output_accuracy(output, 1e-6);
+
+  size_t output_size = zfp_compress_eplane(output, input);
+  size_t regular_size = compress_regular(output);
+  report("Exponent plane", output_size, regular_size);
+  EXPECT_LT(output_size, regular_size);
+
+  //* Same blocks, only the exponents moved.
+  stream_rewind(output->data);
+  EXPECT_EQ(zfp_decompress_eplane(output, yin), output_size);
+  expect_regular_values();
+  free_zfp_output(output);
+}
+
+TEST_F(TestLayout2D, sparse_2d)
+{
+  init(210, 123);
+  //* ReLU-like activations: mostly zeros, with values below the tolerance.
+  for (size_t j = 0; j < ny; j++)
+    for (size_t i = 0; i < nx; i++) {
+      float v = (float)(sin(0.05 * i) * sin(0.07 * j));
+      x[i + nx * j] = v > 0.5f ? v : (v > 0 ? 1e-9f * v : 0.0f);
+    }
+  zfp_output *output = init_zfp_output(input);
+  set_zfp_output_accuracy(output, 1e-4);
+
+  size_t blocks = get_input_num_blocks(input);
+  std::vector<uint64> bitmap((blocks + 63) / 64);
+  size_t zeros = get_zero_block_bitmap(bitmap.data(), output, input);
+  printf("%zu/%zu zero blocks\n", zeros, blocks);
+  EXPECT_GT(zeros, blocks / 2);
+  EXPECT_LT(zeros, blocks);
+
+  size_t output_size = zfp_compress_sparse_2d(output, input);
+  size_t regular_size = compress_regular(output);
+  report("Sparse", output_size, regular_size);
+  EXPECT_LT(output_size, regular_size);
+
+  //* Nonzero blocks are coded as in the regular layout.
+  memset(y, 0xff, n * sizeof(float));
+  stream_rewind(output->data);
+  EXPECT_EQ(zfp_decompress_sparse_2d(output, yin), output_size);
+  expect_regular_values();
+  free_zfp_output(output);
+}
+
+TEST_F(TestLayout2D, rans_2d)
+{
+  init(123, 210);
+  for (size_t i = 0; i < n; i++)
+    x[i] = (float)(1e-3 * exp(-1e-4 * i) * sin(0.37 * i) + 1e-5 * cos(i));
+
+  //* Accuracy and (truncated) fixed rate.
+  for (int mode = 0; mode < 2; mode++) {
+    zfp_output *output = init_zfp_output(input);
+    if (mode)
+      set_zfp_output_rate(output, 6, 2);
+    else
+      set_zfp_output_accuracy(output, 1e-7);
+
+    size_t output_size = zfp_compress_rans(output, input);
+    size_t regular_size = compress_regular(output);
+    report("rANS", output_size, regular_size);
+    EXPECT_LT(output_size, regular_size);
+
+    //* Only the coding of the bits differs.
+    stream_rewind(output->data);
+    EXPECT_EQ(zfp_decompress_rans(output, yin), output_size);
+    expect_regular_values();
+    free_zfp_output(output);
+  }
+}
+
+TEST_F(TestLayout2D, lanes_2d)
+{
+  init(210, 123);
+  for (size_t i = 0; i < n; i++)
+    x[i] = (float)(1e-3 * exp(-1e-4 * i) * sin(0.37 * i));
+
+  for (uint lanes = 1; lanes <= 16; lanes *= 4) {
+    zfp_output *output = init_zfp_output(input);
+    set_zfp_output_accuracy(output, 1e-6);
+    size_t output_size = zfp_compress_lanes(output, input, lanes);
+    size_t regular_size = compress_regular(output);
+    char layout[16];
+    snprintf(layout, sizeof(layout), "%u lanes", lanes);
+    report(layout, output_size, regular_size);
+    //* The header and the padding of the shorter lanes cost little.
+    EXPECT_LE(output_size, regular_size + regular_size / 100 + 8 * lanes);
+
+    memset(y, 0, n * sizeof(float));
+    stream_rewind(output->data);
+    EXPECT_EQ(zfp_decompress_lanes(output, yin), output_size);
+    expect_regular_values();
+    free_zfp_output(output);
+  }
+}
+
+TEST_F(TestLayout2D, adaptive_2d)
+{
+  init(210, 123);
+  //* Smooth, constant and white-noise thirds.
+  uint seed = 7;
+  for (size_t j = 0; j < ny; j++)
+    for (size_t i = 0; i < nx; i++) {
+      seed = seed * 1103515245u + 12345u;
+      float noise = ((seed >> 8) % 65536) / 32768.0f - 1.0f;
+      x[i + nx * j] = i < 70 ? (float)sin(0.05 * i + 0.03 * j) :
+                      i < 140 ? 0.25f : noise;
+    }
+  zfp_output *output = init_zfp_output(input);
+  double tolerance = 1e-4;
+  set_zfp_output_accuracy(output, tolerance);
+  set_zfp_output_adaptive(output, 1);
+
+  size_t output_size = zfp_compress(output, input);
+  size_t regular_size = compress_regular(output);
+  report("Adaptive", output_size, regular_size);
+  EXPECT_LT(output_size, regular_size);
+
+  //* Raw and constant blocks decode to other values than the transform.
+  stream_rewind(output->data);
+  EXPECT_EQ(zfp_decompress(output, yin), output_size);
+  double error = get_max_error(y, x, n);
+  printf("Max error: %g, regular: %g\n", error, get_max_error(z, x, n));
+  EXPECT_LE(error, tolerance);
+
+  //* Operations that parse the regular header leave adaptive streams alone.
+  zfp_output *other = init_zfp_output(input);
+  set_zfp_output_accuracy(other, 1e-2);
+  stream_rewind(output->data);
+  EXPECT_EQ(zfp_add(other, output, output, input), 0u);
+  EXPECT_EQ(zfp_transcode(other, output, input), 0u);
+  EXPECT_EQ(stream_woffset(other->data), 0u);
+  EXPECT_EQ(stream_roffset(output->data), 0u);
+  stream_rewind(output->data);
+  EXPECT_EQ(zfp_compress_eplane(output, input), 0u);
+  EXPECT_EQ(zfp_roundtrip(output, input), 0u);
+  free_zfp_output(other);
+  free_zfp_output(output);
+}
+
+TEST_F(TestLayout2D, bfp_2d)
+{
+  init(123, 45);
+  for (size_t i = 0; i < n; i++)
+    x[i] = (float)(1e-3 * exp(-1e-3 * i) * sin(0.37 * i));
+  zfp_output *output = init_zfp_output(input);
+  uint p = set_zfp_output_precision(output, 12);
+
+  //* Every block takes exactly EBITS + 16 * p bits.
+  size_t blocks = get_input_num_blocks(input);
+  size_t output_size = zfp_compress_bfp(output, input);
+  EXPECT_EQ(output_size, (blocks * (EBITS + 16 * p) + 63) / 64 * 8);
+
+  stream_rewind(output->data);
+  EXPECT_EQ(zfp_decompress_bfp(output, yin), output_size);
+  //* Errors stay below 2^(emax - p) within each 4x4 block.
+  for (size_t j = 0; j < ny; j += 4)
+    for (size_t i = 0; i < nx; i += 4) {
+      float max = 0, error = 0;
+      for (size_t v = j; v < MIN(j + 4, ny); v++)
+        for (size_t u = i; u < MIN(i + 4, nx); u++) {
+          max = fmaxf(max, fabsf(x[u + nx * v]));
+          error = fmaxf(error, fabsf(y[u + nx * v] - x[u + nx * v]));
+        }
+      int emax;
+      frexpf(max, &emax);
+      EXPECT_LE(error, ldexpf(1.0f, emax - (int)p));
+    }
+  free_zfp_output(output);
+}
+
+TEST(zfp, fixed_precision_2d)
+{
+  size_t nx = 210, ny = 123, n = nx * ny;
+  float *x = (float*)malloc(n * sizeof(float));
+  float *y = (float*)malloc(n * sizeof(float));
+  //* Magnitudes spanning about 30 binades.
+  for (size_t j = 0; j < ny; j++)
+    for (size_t i = 0; i < nx; i++)
+      x[i + nx * j] = (float)(exp(-0.1 * i) * sin(0.05 * i + 0.03 * j));
+  zfp_input *input = init_zfp_input(x, dtype_float, 2, nx, ny);
+  zfp_input *yin = init_zfp_input(y, dtype_float, 2, nx, ny);
+  zfp_output *output = init_zfp_output(input);
+
+  EXPECT_EQ(get_zfp_output_mode(output), zfp_fixed_precision);
+  set_zfp_output_accuracy(output, 1e-3);
+  EXPECT_EQ(get_zfp_output_mode(output), zfp_fixed_accuracy);
+  size_t accuracy_bound = get_max_output_bytes(output, input);
+  set_zfp_output_rate(output, 8, 2);
+  EXPECT_EQ(get_zfp_output_mode(output), zfp_fixed_rate);
+
+  double previous = INFINITY;
+  for (uint p : {8u, 16u}) {
+    EXPECT_EQ(set_zfp_output_precision(output, p), p);
+    EXPECT_EQ(get_zfp_output_mode(output), zfp_fixed_precision);
+    stream_rewind(output->data);
+    size_t output_size = zfp_compress(output, input);
+    //* The precision bounds the size of every block.
+    EXPECT_LE(output_size, get_max_output_bytes(output, input));
+    EXPECT_LT(get_max_output_bytes(output, input), accuracy_bound);
+
+    stream_rewind(output->data);
+    EXPECT_EQ(zfp_decompress(output, yin), output_size);
+    //* Errors are relative to each block: below 2^(emax - p + 2 * dim + 2).
+    double error = 0;
+    for (size_t j = 0; j < ny; j += 4)
+      for (size_t i = 0; i < nx; i += 4) {
+        float max = 0, block_error = 0;
+        for (size_t v = j; v < MIN(j + 4, ny); v++)
+          for (size_t u = i; u < MIN(i + 4, nx); u++) {
+            max = fmaxf(max, fabsf(x[u + nx * v]));
+            block_error = fmaxf(block_error,
+                                fabsf(y[u + nx * v] - x[u + nx * v]));
+          }
+        int emax;
+        frexpf(max, &emax);
+        EXPECT_LE(block_error, ldexpf(1.0f, emax - (int)p + 6));
+        error = fmax(error, block_error / max);
+      }
+    printf("Precision %u: %zu bytes, max relative error %g\n", p,
+           output_size, error);
+    EXPECT_LT(error, previous);
+    previous = error;
+  }
+
+  free_zfp_input(yin);
+  cleanup(input, output);
+}
+
+TEST(zfp, group_rate_2d)
+{
+  size_t nx = 210, ny = 123, n = nx * ny;
+  float *x = (float*)malloc(n * sizeof(float));
+  float *y = (float*)malloc(n * sizeof(float));
+  //* Smooth, zero and white-noise thirds of every row of blocks.
+  uint seed = 3;
+  for (size_t j = 0; j < ny; j++)
+    for (size_t i = 0; i < nx; i++) {
+      seed = seed * 1103515245u + 12345u;
+      float noise = ((seed >> 8) % 65536) / 32768.0f - 1.0f;
+      x[i + nx * j] = i < 70 ? (float)sin(0.05 * i + 0.03 * j) :
+                      i < 140 ? 0.0f : noise;
+    }
+  zfp_input *input = init_zfp_input(x, dtype_float, 2, nx, ny);
+  zfp_input *yin = init_zfp_input(y, dtype_float, 2, nx, ny);
+  zfp_output *output = init_zfp_output(input);
+  double rate = 8;
+  size_t blocks = get_input_num_blocks(input);
+
+  set_zfp_output_rate(output, rate, 2);
+  size_t fixed_size = zfp_compress(output, input);
+  stream_rewind(output->data);
+  zfp_decompress(output, yin);
+  double fixed_error = 0;
+  for (size_t i = 0; i < n; i++)
+    fixed_error += (y[i] - x[i]) * (y[i] - x[i]);
+
+  //* One row of blocks per window: the zero blocks fund the noisy ones.
+  set_zfp_output_group_rate(output, rate, 1e-4, 2);
+  stream_rewind(output->data);
+  size_t output_size = zfp_compress_group_rate(output, input, 0);
+  EXPECT_EQ(output_size, (blocks * output->maxbits + 63) / 64 * 8);
+  EXPECT_EQ(output_size, fixed_size);
+  stream_rewind(output->data);
+  EXPECT_EQ(zfp_decompress_group_rate(output, yin, 0), output_size);
+  double error = 0;
+  for (size_t i = 0; i < n; i++)
+    error += (y[i] - x[i]) * (y[i] - x[i]);
+  printf("RMSE: %g, fixed rate: %g\n", sqrt(error / n),
+         sqrt(fixed_error / n));
+  EXPECT_LT(error, fixed_error / 2);
+
+  free_zfp_input(yin);
+  cleanup(input, output);
+}
+
+TEST(zfp, tune_accuracy_2d)
+{
+  size_t nx = 512, ny = 256, n = nx * ny;
+  float *x = (float*)malloc(n * sizeof(float));
+  //* Gradient-like noise whose magnitude varies across rows.
+  uint seed = 11;
+  for (size_t j = 0; j < ny; j++)
+    for (size_t i = 0; i < nx; i++) {
+      seed = seed * 1103515245u + 12345u;
+      float noise = ((seed >> 8) % 65536) / 32768.0f - 1.0f;
+      x[i + nx * j] = 1e-3f * (1 + j % 7) * noise * noise * noise;
+    }
+  zfp_input *input = init_zfp_input(x, dtype_float, 2, nx, ny);
+  zfp_output *output = init_zfp_output(input);
+  size_t target = n * 6 / CHAR_BIT;
+  zfp_tuner *tuner = alloc_zfp_tuner(target, 8);
+
+  int minexp = 0;
+  for (int step = 0; step < 4; step++) {
+    if (step == 2)
+      //* The gradients shrink: the tolerance must follow.
+      for (size_t i = 0; i < n; i++)
+        x[i] /= 64;
+    double tolerance = tune_zfp_output_accuracy(tuner, output, input);
+    stream_rewind(output->data);
+    size_t output_size = zfp_compress(output, input);
+    update_zfp_tuner(tuner, output_size);
+    printf("Step %d: tolerance %g, %zu bytes (target %zu)\n", step,
+           tolerance, output_size, target);
+    EXPECT_LE(output_size, target + target / 20);
+    EXPECT_GE(output_size, target - target / 4);
+    if (step == 1) {
+      EXPECT_EQ(tuner->minexp, minexp);
+    }
+    if (step == 2) {
+      EXPECT_LE(tuner->minexp, minexp - 5);
+    }
+    minexp = tuner->minexp;
+  }
+
+  free_zfp_tuner(tuner);
+  cleanup(input, output);
+}
+
+TEST(zfp, estimate_output_bytes_2d)
+{
+  size_t nx = 512, ny = 256, n = nx * ny;
+  float *x = (float*)malloc(n * sizeof(float));
+  //* Noisy top half, smooth bottom half.
+  uint seed = 5;
+  for (size_t j = 0; j < ny; j++)
+    for (size_t i = 0; i < nx; i++) {
+      seed = seed * 1103515245u + 12345u;
+      float noise = ((seed >> 8) % 65536) / 32768.0f - 1.0f;
+      x[i + nx * j] = j < ny / 2 ? 1e-3f * (1 + j % 7) * noise :
+                      (float)sin(0.01 * i + 0.02 * j);
+    }
+  zfp_input *input = init_zfp_input(x, dtype_float, 2, nx, ny);
+  zfp_output *regular = init_zfp_output(input);
+  set_zfp_output_accuracy(regular, 1e-4);
+  size_t regular_size = zfp_compress(regular, input);
+
+  size_t estimate = get_estimated_output_bytes(regular, input, 16, 3);
+  printf("Estimate: %zu bytes, actual: %zu, bound: %zu\n", estimate,
+         regular_size, get_max_output_bytes(regular, input));
+  EXPECT_GE(estimate, regular_size);
+  EXPECT_LE(estimate, regular_size + regular_size / 20);
+  EXPECT_EQ(get_estimated_output_bytes(regular, input, 1, 0),
+            regular_size + sizeof(stream_word));
+
+  //* A buffer far too small takes the overflow path.
+  zfp_output *output = alloc_zfp_output();
+  set_zfp_output_accuracy(output, 1e-4);
+  size_t bytes = estimate / 8;
+  output->data = stream_init(malloc(bytes), bytes);
+  EXPECT_EQ(zfp_compress_growable(output, input), regular_size);
+  EXPECT_GE(stream_capacity_bytes(output->data), regular_size);
+  EXPECT_EQ(memcmp(output->data->begin, regular->data->begin, regular_size),
+            0);
+
+  free_zfp_output(output);
+  cleanup(input, regular);
+}
+
+TEST(zfp, capped_2d)
+{
+  size_t nx = 210, ny = 123, n = nx * ny;
+  float *x = (float*)malloc(n * sizeof(float));
+  float *y = (float*)malloc(n * sizeof(float));
+  for (size_t j = 0; j < ny; j++)
+    for (size_t i = 0; i < nx; i++)
+      x[i + nx * j] = (float)(sin(0.05 * i) * cos(0.3 * j) + 1e-3 * (i % 7));
+  zfp_input *input = init_zfp_input(x, dtype_float, 2, nx, ny);
+  zfp_input *yin = init_zfp_input(y, dtype_float, 2, nx, ny);
+  zfp_output *output = init_zfp_output(input);
+  double tolerance = 1e-5;
+  set_zfp_output_accuracy(output, tolerance);
+  size_t full_size = zfp_compress(output, input);
+  size_t blocks = get_input_num_blocks(input);
+  ptrdiff_t end = output->data->end;
+
+  //* Words past the end of a regular stream are dropped.
+  stream_word *buffer = output->data->begin;
+  size_t capacity = full_size / 2;
+  buffer[capacity / sizeof(stream_word)] = 12345;
+  output->data->end = capacity / sizeof(stream_word);
+  stream_rewind(output->data);
+  EXPECT_EQ(zfp_compress(output, input), full_size);
+  EXPECT_EQ(buffer[capacity / sizeof(stream_word)], 12345u);
+
+  //* Fixed-rate fallback: all blocks fit, the tail at a lower rate.
+  zfp_cap *cap = alloc_zfp_cap(zfp_overflow_fixed_rate);
+  stream_rewind(output->data);
+  EXPECT_LE(zfp_compress_capped(output, input, cap), capacity);
+  EXPECT_EQ(cap->block, blocks);
+  //* At least half the mean budget per block.
+  EXPECT_GE(cap->fallback_bits, (capacity - 8) * CHAR_BIT / blocks / 2);
+  zfp_cap *dcap = alloc_zfp_cap(zfp_overflow_fixed_rate);
+  stream_rewind(output->data);
+  zfp_decompress_capped(output, yin, dcap);
+  EXPECT_EQ(dcap->block, blocks);
+  EXPECT_EQ(dcap->fallback_bits, cap->fallback_bits);
+  //* The first rows of blocks were coded at the requested accuracy.
+  for (size_t i = 0; i < 4 * nx; i++)
+    EXPECT_LE(fabs(y[i] - x[i]), tolerance);
+
+  //* Resumable: pieces of at most a third of the stream each.
+  cap->overflow = zfp_overflow_resume;
+  reset_zfp_cap(cap);
+  reset_zfp_cap(dcap);
+  output->data->end = full_size / 3 / sizeof(stream_word);
+  uint pieces = 0;
+  while (cap->block < blocks && pieces < 10) {
+    size_t first = cap->block;
+    stream_rewind(output->data);
+    size_t piece_size = zfp_compress_capped(output, input, cap);
+    EXPECT_LE(piece_size, stream_capacity_bytes(output->data));
+    EXPECT_GT(cap->block, first);
+    stream_rewind(output->data);
+    EXPECT_EQ(zfp_decompress_capped(output, yin, dcap), piece_size);
+    EXPECT_EQ(dcap->block, cap->block);
+    pieces++;
+  }
+  EXPECT_EQ(pieces, 4u);
+  double error = 0;
+  for (size_t i = 0; i < n; i++)
+    error = fmax(error, fabs(y[i] - x[i]));
+  EXPECT_LE(error, tolerance);
+
+  //* No fallback without an overflow, even when the costly blocks come
+  //* first and the array only just fits.
+  for (size_t i = n / 2; i < n; i++)
+    x[i] = 0.5f;
+  output->data->end = end;
+  stream_rewind(output->data);
+  full_size = zfp_compress(output, input);
+  output->data->end = (full_size + sizeof(stream_word)) / sizeof(stream_word);
+  cap->overflow = zfp_overflow_fixed_rate;
+  reset_zfp_cap(cap);
+  reset_zfp_cap(dcap);
+  stream_rewind(output->data);
+  EXPECT_EQ(zfp_compress_capped(output, input, cap),
+            full_size + sizeof(stream_word));
+  EXPECT_EQ(cap->block, blocks);
+  EXPECT_EQ(cap->fallback_bits, 0u);
+  stream_rewind(output->data);
+  zfp_decompress_capped(output, yin, dcap);
+  EXPECT_LE(get_max_error(x, y, n), tolerance);
+
+  //* A cap below the header word codes nothing; one word codes no block.
+  for (ptrdiff_t words = 0; words < 2; words++) {
+    buffer[0] = 12345;
+    output->data->end = words;
+    cap->block = dcap->block = blocks / 2;
+    stream_rewind(output->data);
+    EXPECT_EQ(zfp_compress_capped(output, input, cap),
+              words * sizeof(stream_word));
+    EXPECT_EQ(cap->block, blocks / 2);
+    if (!words)
+      EXPECT_EQ(buffer[0], 12345u);
+    stream_rewind(output->data);
+    EXPECT_EQ(zfp_decompress_capped(output, yin, dcap),
+              words * sizeof(stream_word));
+    EXPECT_EQ(dcap->block, blocks / 2);
+  }
+
+  free_zfp_cap(cap);
+  free_zfp_cap(dcap);
+  free_zfp_input(yin);
+  cleanup(input, output);
+}
+
+TEST(zfp, error_feedback_2d)
+{
+  size_t nx = 123, ny = 45, n = nx * ny;
+  double tolerance = 1e-2;
+  float *x = (float*)malloc(n * sizeof(float));
+  float *y = (float*)malloc(n * sizeof(float));
+  //* Mostly below the tolerance: dropped at every step without feedback.
+  for (size_t j = 0; j < ny; j++)
+    for (size_t i = 0; i < nx; i++)
+      x[i + nx * j] = (float)(0.01 * tolerance +
+                              (i < 20 ? 10 * tolerance * sin(0.3 * j) : 0));
+  zfp_input *input = init_zfp_input(x, dtype_float, 2, nx, ny);
+  zfp_input *yin = init_zfp_input(y, dtype_float, 2, nx, ny);
+  zfp_output *output = init_zfp_output(input);
+  set_zfp_output_accuracy(output, tolerance);
+  zfp_feedback *state = alloc_zfp_feedback(input);
+  std::vector<double> sum(n, 0.0), plain(n, 0.0);
+
+  int steps = 16;
+  for (int t = 0; t < steps; t++) {
+    stream_rewind(output->data);
+    size_t output_size = zfp_compress_feedback(output, input, state);
+    stream_rewind(output->data);
+    EXPECT_EQ(zfp_decompress(output, yin), output_size);
+    for (size_t i = 0; i < n; i++) {
+      //* The fused residual is what a decompress and subtract would give.
+      if (!t) {
+        EXPECT_EQ(state->residual[i], x[i] - y[i]);
+      }
+      sum[i] += y[i];
+    }
+  }
+  stream_rewind(output->data);
+  zfp_compress(output, input);
+  stream_rewind(output->data);
+  zfp_decompress(output, yin);
+
+  double error = 0, plain_error = 0;
+  for (size_t i = 0; i < n; i++) {
+    error = fmax(error, fabs(sum[i] - steps * x[i]));
+    plain_error = fmax(plain_error, fabs(steps * (y[i] - x[i])));
+  }
+  printf("Error of the sum: %g, without feedback: %g\n", error, plain_error);
+  EXPECT_LE(error, tolerance);
+  EXPECT_LT(error, plain_error / 4);
+
+  free_zfp_feedback(state);
+  free_zfp_input(yin);
+  cleanup(input, output);
+}
+
+TEST(zfp, error_stats_2d)
+{
+  //* Partial blocks on both edges.
+  size_t nx = 210, ny = 123, n = nx * ny;
+  double tolerance = 1e-3;
+  float *x = (float*)malloc(n * sizeof(float));
+  float *y = (float*)malloc(n * sizeof(float));
+  for (size_t j = 0; j < ny; j++)
+    for (size_t i = 0; i < nx; i++)
+      x[i + nx * j] = (float)(sin(0.05 * i) * cos(0.07 * j) + 0.5);
+  zfp_input *input = init_zfp_input(x, dtype_float, 2, nx, ny);
+  zfp_input *yin = init_zfp_input(y, dtype_float, 2, nx, ny);
+  zfp_output *output = init_zfp_output(input);
+  set_zfp_output_accuracy(output, tolerance);
+  zfp_stats *stats = set_zfp_output_stats(output, 1);
+  ASSERT_NE(stats, nullptr);
+
+  size_t output_size = zfp_compress(output, input);
+  stream_rewind(output->data);
+  EXPECT_EQ(zfp_decompress(output, yin), output_size);
+
+  double max_error = 0, sum_error2 = 0;
+  float min = x[0], max = x[0];
+  for (size_t i = 0; i < n; i++) {
+    double e = fabs((double)y[i] - x[i]);
+    max_error = fmax(max_error, e);
+    sum_error2 += e * e;
+    min = fminf(min, x[i]);
+    max = fmaxf(max, x[i]);
+  }
+  double rmse = sqrt(sum_error2 / n);
+  printf("Max error %g, RMSE %g, PSNR %g dB\n", stats->max_error,
+         stats->rmse, stats->psnr);
+  EXPECT_EQ(stats->count, n);
+  EXPECT_EQ(stats->max_error, max_error);
+  EXPECT_NEAR(stats->rmse, rmse, 1e-9 * rmse);
+  EXPECT_EQ(stats->min, min);
+  EXPECT_EQ(stats->max, max);
+  EXPECT_NEAR(stats->psnr, 20 * log10((max - min) / (2 * rmse)), 1e-6);
+  EXPECT_LE(stats->max_error, tolerance);
+
+  //* Disabling the statistics leaves the stream unchanged.
+  EXPECT_EQ(set_zfp_output_stats(output, 0), nullptr);
+  stream_rewind(output->data);
+  EXPECT_EQ(zfp_compress(output, input), output_size);
+
+  free_zfp_input(yin);
+  cleanup(input, output);
+}
+
 INSTANTIATE_TEST_SUITE_P(zfp, TestZfp2D, ::testing::Values(
                            3, 8, 123, 210, 354, 510, 7654//, 10240
                          ));
 
+/**
+ * Gradient shapes of ResNet-50 as (rows, cols): conv weights are viewed as
+ * [out][in*kh*kw], BatchNorm/bias vectors as a single row.
+*/
+std::vector<std::pair<size_t, size_t>> get_resnet50_shapes()
+{
+  std::vector<std::pair<size_t, size_t>> shapes;
+  shapes.push_back(std::make_pair(64, 3 * 7 * 7));
+  shapes.push_back(std::make_pair(1, 64));
+  shapes.push_back(std::make_pair(1, 64));
+  size_t blocks[4] = {3, 4, 6, 3};
+  size_t in = 64;
+  for (size_t stage = 0; stage < 4; stage++) {
+    size_t width = 64u << stage;
+    for (size_t b = 0; b < blocks[stage]; b++) {
+      size_t out = 4 * width;
+      shapes.push_back(std::make_pair(width, in));
+      shapes.push_back(std::make_pair(1, width));
+      shapes.push_back(std::make_pair(1, width));
+      shapes.push_back(std::make_pair(width, width * 3 * 3));
+      shapes.push_back(std::make_pair(1, width));
+      shapes.push_back(std::make_pair(1, width));
+      shapes.push_back(std::make_pair(out, width));
+      shapes.push_back(std::make_pair(1, out));
+      shapes.push_back(std::make_pair(1, out));
+      if (!b) {
+        shapes.push_back(std::make_pair(out, in));
+        shapes.push_back(std::make_pair(1, out));
+        shapes.push_back(std::make_pair(1, out));
+      }
+      in = out;
+    }
+  }
+  shapes.push_back(std::make_pair(1000, 2048));
+  shapes.push_back(std::make_pair(1, 1000));
+  return shapes;
+}
+
+/* Synthetic gradient: per-row scale, smooth along the row, small noise */
+void get_gradient(float *data, size_t rows, size_t cols, uint seed)
+{
+  for (size_t r = 0; r < rows; r++) {
+    seed = seed * 1103515245u + 12345u;
+    float scale = 1e-3f * (1 + (seed >> 16) % 100);
+    for (size_t c = 0; c < cols; c++) {
+      seed = seed * 1103515245u + 12345u;
+      float noise = ((seed >> 16) % 1000) / 1000.0f - 0.5f;
+      data[cols * r + c] = scale * ((float)cos(0.05 * c + r) + 0.1f * noise);
+    }
+  }
+}
+
+size_t count_partial_blocks(size_t nx, size_t ny)
+{
+  size_t bx = (nx + 3) / 4, by = (ny + 3) / 4;
+  return bx * by - (nx / 4) * (ny / 4);
+}
+
+/* Compressed size of an nx*ny array, decompressed into decoded if given */
+size_t compress_2d_bytes(float *data, size_t nx, size_t ny, double tolerance,
+                         float *decoded = NULL)
+{
+  zfp_input *input = init_zfp_input(data, dtype_float, 2, nx, ny);
+  zfp_output *output = init_zfp_output(input);
+  set_zfp_output_accuracy(output, tolerance);
+  size_t bytes = zfp_compress(output, input);
+  if (decoded) {
+    input->data = decoded;
+    stream_rewind(output->data);
+    zfp_decompress_2d(output, input);
+  }
+  input->data = NULL;
+  cleanup(input, output);
+  return bytes;
+}
+
+TEST(zfp, bucket_resnet50)
+{
+  std::vector<std::pair<size_t, size_t>> shapes = get_resnet50_shapes();
+  std::vector<zfp_tensor> tensors(shapes.size());
+  std::vector<std::vector<float>> values(shapes.size());
+  for (size_t i = 0; i < shapes.size(); i++) {
+    values[i].resize(shapes[i].first * shapes[i].second);
+    get_gradient(values[i].data(), shapes[i].first, shapes[i].second, i);
+    tensors[i].data = values[i].data();
+    tensors[i].rows = shapes[i].first;
+    tensors[i].cols = shapes[i].second;
+  }
+
+  double tolerance = 1e-5;
+  size_t capacity = 1u << 20;
+  zfp_bucket_layout *layout = plan_zfp_buckets(tensors.data(), tensors.size(),
+                                               capacity);
+  size_t raw_bytes = 0, bucket_bytes = 0, square_bytes = 0;
+  size_t bucket_partial = 0, square_partial = 0;
+  size_t bucket_values = 0, square_values = 0;
+
+  for (size_t b = 0; b < layout->num_buckets; b++) {
+    const zfp_bucket *bucket = layout->buckets + b;
+    EXPECT_EQ(bucket->nx % 4, 0u);
+    EXPECT_EQ(bucket->ny % 4, 0u);
+
+    //* Bucketed: row-preserving shape.
+    std::vector<float> packed(bucket->nx * bucket->ny);
+    std::vector<float> decoded(packed.size());
+    pack_zfp_bucket(packed.data(), bucket, tensors.data());
+    bucket_bytes += compress_2d_bytes(packed.data(), bucket->nx, bucket->ny,
+                                      tolerance, decoded.data());
+    bucket_partial += count_partial_blocks(bucket->nx, bucket->ny);
+    bucket_values += packed.size();
+
+    //* Naive: the same values flattened into a square.
+    std::vector<float> flat;
+    for (size_t s = 0; s < bucket->count; s++) {
+      const zfp_tensor *t = &tensors[bucket->slots[s].tensor];
+      flat.insert(flat.end(), t->data, t->data + t->rows * t->cols);
+    }
+    raw_bytes += flat.size() * sizeof(float);
+    size_t side = (size_t)ceil(sqrt((double)flat.size()));
+    size_t rows = (flat.size() + side - 1) / side;
+    flat.resize(side * rows, 0.0f);
+    square_bytes += compress_2d_bytes(flat.data(), side, rows, tolerance);
+    square_partial += count_partial_blocks(side, rows);
+    square_values += flat.size();
+
+    //* The layout restores every tensor exactly.
+    std::vector<std::vector<float>> restored(bucket->count);
+    std::vector<zfp_tensor> targets(tensors);
+    for (size_t s = 0; s < bucket->count; s++) {
+      size_t i = bucket->slots[s].tensor;
+      restored[s].resize(values[i].size());
+      targets[i].data = restored[s].data();
+    }
+    unpack_zfp_bucket(packed.data(), bucket, targets.data());
+    for (size_t s = 0; s < bucket->count; s++)
+      EXPECT_EQ(restored[s], values[bucket->slots[s].tensor]);
+
+    //* And every tensor within the tolerance after the round trip.
+    unpack_zfp_bucket(decoded.data(), bucket, targets.data());
+    for (size_t s = 0; s < bucket->count; s++) {
+      const std::vector<float> &v = values[bucket->slots[s].tensor];
+      EXPECT_LE(get_max_error(restored[s].data(), v.data(), v.size()),
+                tolerance);
+    }
+  }
+
+  printf("ResNet-50: %zu tensors, %zu buckets, %zu raw bytes\n",
+         tensors.size(), layout->num_buckets, raw_bytes);
+  printf("Bucketed:\t%zu bytes (%.2fx), %zu partial blocks, %zu values\n",
+         bucket_bytes, (double)raw_bytes / bucket_bytes, bucket_partial,
+         bucket_values);
+  printf("Square:\t\t%zu bytes (%.2fx), %zu partial blocks, %zu values\n",
+         square_bytes, (double)raw_bytes / square_bytes, square_partial,
+         square_values);
+  EXPECT_EQ(bucket_partial, 0u);
+  EXPECT_LT(bucket_bytes, square_bytes);
+  free_zfp_bucket_layout(layout);
+}
+
 int main(int argc, char** argv)
 {
   printf("\nZFP Tests: \n");